@@ -0,0 +1,77 @@
+// atlas.cpp
+#include "atlas.hpp"
+
+#include <algorithm>
+
+int TextureAtlas::add(const std::string& path) {
+    sf::Image image;
+    if (!image.loadFromFile(path)) return -1;
+    return add(image);
+}
+
+int TextureAtlas::add(const sf::Image& image) {
+    images.push_back(image);
+    rects.push_back(sf::IntRect());
+    return static_cast<int>(images.size()) - 1;
+}
+
+// Copies the tile into the atlas at (x, y) and repeats its outermost pixels into the padding
+static void blit(sf::Image& atlas, const sf::Image& tile, unsigned x, unsigned y) {
+    sf::Vector2u size = tile.getSize();
+    atlas.copy(tile, x, y);
+
+    // Top and bottom rows first, so the column pass below finds every padded row filled in
+    for (unsigned i = 1; i <= ATLAS_PADDING; ++i) {
+        for (unsigned col = 0; col < size.x; ++col) {
+            atlas.setPixel(x + col, y - i, tile.getPixel(col, 0));
+            atlas.setPixel(x + col, y + size.y - 1 + i, tile.getPixel(col, size.y - 1));
+        }
+    }
+    // Left and right columns over the padded height, which extrudes the corners too
+    for (unsigned row = 0; row < size.y + 2 * ATLAS_PADDING; ++row) {
+        unsigned atlasRow = y - ATLAS_PADDING + row;
+        for (unsigned i = 1; i <= ATLAS_PADDING; ++i) {
+            atlas.setPixel(x - i, atlasRow, atlas.getPixel(x, atlasRow));
+            atlas.setPixel(x + size.x - 1 + i, atlasRow, atlas.getPixel(x + size.x - 1, atlasRow));
+        }
+    }
+}
+
+bool TextureAtlas::pack(unsigned maxWidth) {
+    if (images.empty()) return false;
+
+    std::vector<int> order(images.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        return images[a].getSize().y > images[b].getSize().y;
+    });
+
+    // Place tiles left to right on shelves as tall as their first (tallest) tile
+    unsigned x = 0;
+    unsigned y = 0;
+    unsigned shelfHeight = 0;
+    unsigned width = 0;
+    for (int tile : order) {
+        sf::Vector2u size = images[tile].getSize();
+        unsigned paddedWidth = size.x + 2 * ATLAS_PADDING;
+        unsigned paddedHeight = size.y + 2 * ATLAS_PADDING;
+        if (paddedWidth > maxWidth) return false;
+
+        if (x + paddedWidth > maxWidth) {
+            y += shelfHeight;
+            x = 0;
+            shelfHeight = 0;
+        }
+        rects[tile] = sf::IntRect(x + ATLAS_PADDING, y + ATLAS_PADDING, size.x, size.y);
+        x += paddedWidth;
+        shelfHeight = std::max(shelfHeight, paddedHeight);
+        width = std::max(width, x);
+    }
+
+    sf::Image atlas;
+    atlas.create(width, y + shelfHeight, sf::Color(0, 0, 0, 0));
+    for (size_t tile = 0; tile < images.size(); ++tile) {
+        blit(atlas, images[tile], rects[tile].left, rects[tile].top);
+    }
+    return atlasTexture.loadFromImage(atlas);
+}
@@ -0,0 +1,38 @@
+// atlas.hpp
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <string>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#define ATLAS_PADDING 2 // Pixels of extruded border around each tile, so smooth sampling never bleeds
+#define ATLAS_MAX_WIDTH 2048 // Shelves wrap at this width
+
+// Packs tile images into one texture at startup, so everything drawn from it can share a single
+// vertex array and texture bind. Add the images, pack(), then look tiles up by the index add()
+// returned.
+class TextureAtlas {
+public:
+    // Returns the tile index, or -1 if the file could not be loaded
+    int add(const std::string& path);
+    int add(const sf::Image& image);
+
+    // Shelf-packs the tiles (tallest first) and uploads the atlas texture
+    bool pack(unsigned maxWidth = ATLAS_MAX_WIDTH);
+
+    const sf::Texture& texture() const { return atlasTexture; }
+    sf::Texture& texture() { return atlasTexture; }
+
+    // Pixel rect of a tile inside the atlas texture, padding excluded
+    const sf::IntRect& rect(int tile) const { return rects[tile]; }
+    int size() const { return static_cast<int>(images.size()); }
+
+private:
+    std::vector<sf::Image> images;
+    std::vector<sf::IntRect> rects;
+    sf::Texture atlasTexture;
+};
+
+#endif // ATLAS_H
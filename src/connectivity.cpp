@@ -0,0 +1,145 @@
+// connectivity.cpp
+#include "connectivity.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+// Root of i with path halving
+static int64_t findRoot(std::vector<int64_t>& parent, int64_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// Links the two trees, always keeping the smaller index as the root
+static void unite(std::vector<int64_t>& parent, int64_t a, int64_t b) {
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if (a < b) parent[b] = a;
+    else if (b < a) parent[a] = b;
+}
+
+void ConnectivityIndex::build(const Grid& grid, int threads) {
+    rowCount = grid.rows();
+    colCount = grid.cols();
+    int bands = gridThreads(threads, rowCount, colCount);
+
+    // 1. Union-find inside each band of rows; a band only touches its own cells
+    std::vector<int64_t> parent(grid.size(), -1);
+    parallelFor(0, rowCount, bands, [&](int rowBegin, int rowEnd, int) {
+        for (int row = rowBegin; row < rowEnd; ++row) {
+            const uint8_t* cells = grid[row];
+            for (int col = 0; col < colCount; ++col) {
+                if (cells[col] != PATH) continue;
+                int64_t i = static_cast<int64_t>(index(row, col));
+                parent[i] = i;
+                if (col > 0 && cells[col - 1] == PATH) unite(parent, i, i - 1);
+                if (row > rowBegin && grid[row - 1][col] == PATH) unite(parent, i, i - colCount);
+            }
+        }
+    });
+
+    // 2. Stitch the bands together along their first rows
+    for (int band = 1; band < bands; ++band) {
+        int row = bandBegin(0, rowCount, bands, band);
+        for (int col = 0; col < colCount; ++col) {
+            if (grid[row][col] == PATH && grid[row - 1][col] == PATH) {
+                int64_t i = static_cast<int64_t>(index(row, col));
+                unite(parent, i, i - colCount);
+            }
+        }
+    }
+
+    // 3. Resolve every cell to its root; parent is read-only from here on
+    labels.assign(grid.size(), -1);
+    parallelFor(0, rowCount, bands, [&](int rowBegin, int rowEnd, int) {
+        for (size_t i = index(rowBegin, 0); i < index(rowEnd, 0); ++i) {
+            int64_t root = parent[i];
+            if (root < 0) continue;
+            while (parent[root] != root) root = parent[root];
+            labels[i] = root;
+        }
+    });
+
+    // 4. Renumber roots densely; a root is the smallest index of its region, so it is always
+    // reached before any other cell of that region
+    sizes.clear();
+    largest = -1;
+    for (size_t i = 0; i < labels.size(); ++i) {
+        if (labels[i] < 0) continue;
+        if (static_cast<size_t>(labels[i]) == i) {
+            labels[i] = static_cast<int64_t>(sizes.size());
+            sizes.push_back(0);
+        } else {
+            labels[i] = labels[labels[i]];
+        }
+        int64_t region = labels[i];
+        if (++sizes[region] > (largest < 0 ? 0 : sizes[largest])) largest = region;
+    }
+
+    distances.clear();
+    farthest = 0;
+}
+
+void ConnectivityIndex::buildDistanceField(const Grid& grid, const Cell& spawn) {
+    static const int offsets[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+    spawnCell = spawn;
+    farthest = 0;
+    distances.assign(grid.size(), -1);
+    if (!grid.inBounds(spawn.row, spawn.col) || grid[spawn.row][spawn.col] != PATH) return;
+
+    // Plain array queue: every cell is enqueued at most once
+    std::vector<int64_t> queue;
+    queue.reserve(sizes[label(spawn.row, spawn.col)]);
+    queue.push_back(static_cast<int64_t>(index(spawn.row, spawn.col)));
+    distances[queue[0]] = 0;
+
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int64_t current = queue[head];
+        int row = static_cast<int>(current / colCount);
+        int col = static_cast<int>(current % colCount);
+        int64_t next = distances[current] + 1;
+
+        for (int i = 0; i < 4; ++i) {
+            int newRow = row + offsets[i][0];
+            int newCol = col + offsets[i][1];
+            if (!grid.inBounds(newRow, newCol) || grid[newRow][newCol] != PATH) continue;
+
+            size_t neighbor = index(newRow, newCol);
+            if (distances[neighbor] >= 0) continue;
+            distances[neighbor] = next;
+            farthest = next;
+            queue.push_back(static_cast<int64_t>(neighbor));
+        }
+    }
+}
+
+Cell ConnectivityIndex::nearestInLargest(int row, int col) const {
+    if (largest < 0) return Cell(row, col);
+
+    // Walk rings of growing Manhattan distance around (row, col)
+    for (int d = 0; d < rowCount + colCount; ++d) {
+        for (int dRow = -d; dRow <= d; ++dRow) {
+            int dCol = d - std::abs(dRow);
+            int candidates[2] = {col - dCol, col + dCol};
+            for (int i = 0; i < (dCol == 0 ? 1 : 2); ++i) {
+                int newRow = row + dRow;
+                int newCol = candidates[i];
+                if (newRow >= 0 && newRow < rowCount && newCol >= 0 && newCol < colCount &&
+                    label(newRow, newCol) == largest) {
+                    return Cell(newRow, newCol);
+                }
+            }
+        }
+    }
+    return Cell(row, col);
+}
+
+void ConnectivityIndex::keepLargestOnly(Grid& grid) const {
+    for (size_t i = 0; i < labels.size(); ++i) {
+        if (labels[i] >= 0 && labels[i] != largest) grid.data()[i] = WALL;
+    }
+}
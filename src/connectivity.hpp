@@ -0,0 +1,61 @@
+// connectivity.hpp
+#ifndef CONNECTIVITY_H
+#define CONNECTIVITY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "mazegen.hpp"
+
+// Index built once after generation: labels the 4-connected regions of PATH cells (the cells
+// the player can walk on), keeps their sizes, and holds a BFS distance field from the spawn.
+// Afterwards spawn and reachability questions are lookups instead of searches. Cell indices,
+// labels, sizes and distances are 64-bit, since row * cols passes 2^31 on the largest grids.
+class ConnectivityIndex {
+public:
+    ConnectivityIndex() : rowCount(0), colCount(0), largest(-1), spawnCell(0, 0), farthest(0) {}
+
+    // Labels every region with a union-find over row bands run on `threads` threads.
+    // Labels are numbered in row-major order of each region's first cell, so they do not
+    // depend on the thread count.
+    void build(const Grid& grid, int threads = 1);
+
+    // BFS distances (in steps) from spawn to every cell of its region; -1 elsewhere
+    void buildDistanceField(const Grid& grid, const Cell& spawn);
+
+    int64_t label(int row, int col) const { return labels[index(row, col)]; } // -1 for non-PATH cells
+    int64_t componentCount() const { return static_cast<int64_t>(sizes.size()); }
+    int64_t componentSize(int64_t label) const { return sizes[label]; }
+    int64_t largestComponent() const { return largest; } // -1 if the grid has no PATH cell
+
+    bool connected(int row, int col, int otherRow, int otherCol) const {
+        int64_t first = label(row, col);
+        return first >= 0 && first == label(otherRow, otherCol);
+    }
+
+    const Cell& spawn() const { return spawnCell; }
+    int64_t distance(int row, int col) const { return distances.empty() ? -1 : distances[index(row, col)]; }
+    bool reachable(int row, int col) const { return distance(row, col) >= 0; }
+    int64_t maxDistance() const { return farthest; }
+
+    // Closest cell (Manhattan distance) to (row, col) that lies in the largest region
+    Cell nearestInLargest(int row, int col) const;
+
+    // Turns every PATH cell outside the largest region into a wall; build() again afterwards
+    void keepLargestOnly(Grid& grid) const;
+
+private:
+    int rowCount;
+    int colCount;
+    std::vector<int64_t> labels;
+    std::vector<int64_t> sizes;
+    int64_t largest;
+
+    Cell spawnCell;
+    std::vector<int64_t> distances;
+    int64_t farthest;
+
+    size_t index(int row, int col) const { return static_cast<size_t>(row) * colCount + col; }
+};
+
+#endif // CONNECTIVITY_H
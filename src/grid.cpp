@@ -0,0 +1,104 @@
+// grid.cpp
+#include "grid.hpp"
+
+#include <utility>
+
+Grid::Grid(const Grid& other) : rowCount(other.rowCount), colCount(other.colCount), cells(other.cells) {
+    base = other.isView() ? other.base : cells.data();
+}
+
+Grid::Grid(Grid&& other)
+    : rowCount(other.rowCount), colCount(other.colCount), cells(std::move(other.cells)), base(other.base) {
+    // A moved vector keeps its buffer, so base stays valid for an owning grid too
+    other.cells.clear();
+    other.rowCount = 0;
+    other.colCount = 0;
+    other.base = NULL;
+}
+
+Grid& Grid::operator=(const Grid& other) {
+    if (this != &other) {
+        rowCount = other.rowCount;
+        colCount = other.colCount;
+        cells = other.cells;
+        base = other.isView() ? other.base : cells.data();
+    }
+    return *this;
+}
+
+Grid& Grid::operator=(Grid&& other) {
+    if (this != &other) {
+        rowCount = other.rowCount;
+        colCount = other.colCount;
+        cells = std::move(other.cells);
+        base = other.base;
+        other.cells.clear();
+        other.rowCount = 0;
+        other.colCount = 0;
+        other.base = NULL;
+    }
+    return *this;
+}
+
+Grid Grid::view(uint8_t* cells, int rows, int cols) {
+    Grid grid;
+    grid.rowCount = rows;
+    grid.colCount = cols;
+    grid.base = cells;
+    return grid;
+}
+
+void Grid::resize(int rows, int cols, uint8_t value) {
+    rowCount = rows;
+    colCount = cols;
+    cells.assign(static_cast<size_t>(rows) * cols, value);
+    base = cells.data();
+}
+
+void Grid::packBits(uint8_t value, BitPlane& plane) const {
+    if (plane.rows() != rowCount || plane.cols() != colCount) {
+        plane = BitPlane(rowCount, colCount);
+    }
+
+    for (int row = 0; row < rowCount; ++row) {
+        const uint8_t* src = (*this)[row];
+        uint64_t* dst = plane.row(row);
+
+        for (int word = 0; word < plane.words(); ++word) {
+            int colBegin = word * 64;
+            int colEnd = std::min(colBegin + 64, colCount);
+            uint64_t bits = 0;
+            for (int col = colBegin; col < colEnd; ++col) {
+                bits |= uint64_t(src[col] == value) << (col - colBegin);
+            }
+            dst[word] = bits;
+        }
+    }
+}
+
+void Grid::unpackBits(const BitPlane& plane, uint8_t setValue, uint8_t clearValue) {
+    for (int row = 0; row < rowCount; ++row) {
+        const uint64_t* src = plane.row(row);
+        uint8_t* dst = (*this)[row];
+
+        for (int col = 0; col < colCount; ++col) {
+            dst[col] = ((src[col >> 6] >> (col & 63)) & 1) ? setValue : clearValue;
+        }
+    }
+}
+
+void Grid::orBits(const BitPlane& plane, uint8_t value) {
+    for (int row = 0; row < rowCount; ++row) {
+        const uint64_t* src = plane.row(row);
+        uint8_t* dst = (*this)[row];
+
+        for (int word = 0; word < plane.words(); ++word) {
+            uint64_t bits = src[word];
+            while (bits) {
+                int bit = __builtin_ctzll(bits);
+                dst[word * 64 + bit] = value;
+                bits &= bits - 1;
+            }
+        }
+    }
+}
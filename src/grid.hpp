@@ -0,0 +1,113 @@
+// grid.hpp
+#ifndef GRID_H
+#define GRID_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One bit per cell, 64 cells per word, each row padded to a whole number of words.
+// Bit c % 64 of word c / 64 holds column c; padding bits past the last column stay zero.
+class BitPlane {
+public:
+    BitPlane() : rowCount(0), colCount(0), wordsPerRow(0) {}
+    BitPlane(int rows, int cols)
+        : rowCount(rows), colCount(cols), wordsPerRow((cols + 63) / 64),
+          bits(static_cast<size_t>(rows) * ((cols + 63) / 64), 0) {}
+
+    int rows() const { return rowCount; }
+    int cols() const { return colCount; }
+    int words() const { return wordsPerRow; }
+
+    uint64_t* row(int row) { return &bits[static_cast<size_t>(row) * wordsPerRow]; }
+    const uint64_t* row(int row) const { return &bits[static_cast<size_t>(row) * wordsPerRow]; }
+
+    bool test(int row, int col) const { return (this->row(row)[col >> 6] >> (col & 63)) & 1; }
+    void set(int row, int col) { this->row(row)[col >> 6] |= uint64_t(1) << (col & 63); }
+    void reset(int row, int col) { this->row(row)[col >> 6] &= ~(uint64_t(1) << (col & 63)); }
+    void clear() { std::fill(bits.begin(), bits.end(), 0); }
+
+    // Mask of the valid bits in the last word of a row
+    uint64_t lastWordMask() const {
+        return (colCount & 63) ? (uint64_t(1) << (colCount & 63)) - 1 : ~uint64_t(0);
+    }
+
+private:
+    int rowCount;
+    int colCount;
+    int wordsPerRow;
+    std::vector<uint64_t> bits;
+};
+
+// Walks cells of a grid row. Neighbour reads are relative to the current cell and are
+// not bounds checked, so callers pick a range that keeps the whole stencil inside the grid.
+class GridCursor {
+public:
+    GridCursor(const uint8_t* cell, int stride) : cell(cell), stride(stride) {}
+
+    uint8_t operator*() const { return *cell; }
+    uint8_t at(int dRow, int dCol) const { return cell[dRow * stride + dCol]; }
+
+    GridCursor& operator++() { ++cell; return *this; }
+    bool operator!=(const GridCursor& other) const { return cell != other.cell; }
+
+private:
+    const uint8_t* cell;
+    int stride;
+};
+
+// Maze grid stored row-major in one contiguous allocation, one byte per cell.
+// grid[row] returns a pointer to the row, so grid[row][col] reads like the old nested vectors.
+// A grid can also be a view over cells it does not own (see view()); copies of a view are views
+// of the same cells, copies of an owning grid copy the cells.
+class Grid {
+public:
+    Grid() : rowCount(0), colCount(0), base(NULL) {}
+    Grid(int rows, int cols, uint8_t value = 0)
+        : rowCount(rows), colCount(cols), cells(static_cast<size_t>(rows) * cols, value), base(cells.data()) {}
+    Grid(const Grid& other);
+    Grid(Grid&& other);
+    Grid& operator=(const Grid& other);
+    Grid& operator=(Grid&& other);
+
+    // A grid over rows * cols cells owned by someone else, e.g. a mapped maze file. The cells must
+    // outlive the view and its copies; resize() gives the grid storage of its own again.
+    static Grid view(uint8_t* cells, int rows, int cols);
+    bool isView() const { return base != cells.data(); }
+
+    int rows() const { return rowCount; }
+    int cols() const { return colCount; }
+    int stride() const { return colCount; }
+    size_t size() const { return static_cast<size_t>(rowCount) * colCount; }
+
+    uint8_t* data() { return base; }
+    const uint8_t* data() const { return base; }
+
+    uint8_t* operator[](int row) { return base + static_cast<size_t>(row) * colCount; }
+    const uint8_t* operator[](int row) const { return base + static_cast<size_t>(row) * colCount; }
+
+    bool inBounds(int row, int col) const {
+        return row >= 0 && row < rowCount && col >= 0 && col < colCount;
+    }
+
+    GridCursor cursor(int row, int col) const { return GridCursor(&(*this)[row][col], colCount); }
+
+    void fill(uint8_t value) { std::fill(base, base + size(), value); }
+    void resize(int rows, int cols, uint8_t value = 0);
+
+    // Sets a bit for every cell equal to value (e.g. the wall plane), clearing the rest
+    void packBits(uint8_t value, BitPlane& plane) const;
+    // Writes setValue where the plane has a bit and clearValue everywhere else
+    void unpackBits(const BitPlane& plane, uint8_t setValue, uint8_t clearValue);
+    // Writes value where the plane has a bit and leaves the other cells untouched
+    void orBits(const BitPlane& plane, uint8_t value);
+
+private:
+    int rowCount;
+    int colCount;
+    std::vector<uint8_t> cells; // Empty for a view
+    uint8_t* base;              // cells.data(), or the viewed cells
+};
+
+#endif // GRID_H
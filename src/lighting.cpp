@@ -0,0 +1,293 @@
+// lighting.cpp
+#include "lighting.hpp"
+
+#if defined(__AVX__) || defined(__SSE__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+float lightFalloff(float distanceSquared) {
+    float brightness = AMBIENT_BRIGHTNESS;
+    if (distanceSquared <= LIGHT_RADIUS * LIGHT_RADIUS) {
+        // Attenuation formula 1 / (1.4 + (d / R)^2), contribution of one light source
+        brightness += 1.0f / (1.4f + distanceSquared * (1.0f / (LIGHT_RADIUS * LIGHT_RADIUS)));
+    }
+    return brightness;
+}
+
+// cells[i] = max(cells[i], weights[i]) for i < count: one row of a light's stamp blended into a
+// lightmap row. The SIMD paths are picked at compile time; the scalar loop handles the tail.
+static void maxBlendRow(float* cells, const float* weights, int count) {
+    int i = 0;
+#if defined(__AVX__)
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(cells + i, _mm256_max_ps(_mm256_loadu_ps(cells + i), _mm256_loadu_ps(weights + i)));
+    }
+#endif
+#if defined(__SSE__)
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(cells + i, _mm_max_ps(_mm_loadu_ps(cells + i), _mm_loadu_ps(weights + i)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(cells + i, vmaxq_f32(vld1q_f32(cells + i), vld1q_f32(weights + i)));
+    }
+#endif
+    for (; i < count; ++i) {
+        cells[i] = std::max(cells[i], weights[i]);
+    }
+}
+
+void LightIndex::reset(int rows, int cols) {
+    rowCount = rows;
+    colCount = cols;
+    bucketRows = (rows + LIGHT_BUCKET_SIZE - 1) / LIGHT_BUCKET_SIZE;
+    bucketCols = (cols + LIGHT_BUCKET_SIZE - 1) / LIGHT_BUCKET_SIZE;
+    count = 0;
+    buckets.assign(static_cast<size_t>(bucketRows) * bucketCols, std::vector<Cell>());
+}
+
+void LightIndex::build(int rows, int cols, const Cell* lights, size_t count) {
+    reset(rows, cols);
+    for (size_t i = 0; i < count; ++i) {
+        insert(lights[i]);
+    }
+}
+
+void LightIndex::insert(const Cell& light) {
+    bucketOf(light).push_back(light);
+    ++count;
+}
+
+bool LightIndex::remove(const Cell& light) {
+    std::vector<Cell>& bucket = bucketOf(light);
+    for (size_t i = 0; i < bucket.size(); ++i) {
+        if (bucket[i].row == light.row && bucket[i].col == light.col) {
+            bucket[i] = bucket.back(); // Order within a bucket does not matter
+            bucket.pop_back();
+            --count;
+            return true;
+        }
+    }
+    return false;
+}
+
+void LightIndex::query(int row, int col, float radius, std::vector<Cell>& out) const {
+    int reach = static_cast<int>(radius);
+    float radiusSquared = radius * radius;
+    forEachInBox(row - reach, row + reach + 1, col - reach, col + reach + 1, [&](const Cell& light) {
+        float dx = static_cast<float>(light.col - col);
+        float dy = static_cast<float>(light.row - row);
+        if (dx * dx + dy * dy <= radiusSquared) out.push_back(light);
+    });
+}
+
+// Octant transforms for castOctant: (xx, xy, yx, yy) per octant
+static const int OCTANTS[8][4] = {
+    {1, 0, 0, 1}, {0, 1, 1, 0}, {0, -1, 1, 0}, {-1, 0, 0, 1},
+    {-1, 0, 0, -1}, {0, -1, -1, 0}, {0, 1, -1, 0}, {1, 0, 0, -1},
+};
+
+static bool blocksLight(const Grid& grid, int row, int col) {
+    return !grid.inBounds(row, col) || grid[row][col] != PATH;
+}
+
+// Scans one octant from `distance` outwards between the slopes start > end, recursing past every
+// run of blocking cells with the narrowed slope range
+static void castOctant(const Grid& grid, const Cell& light, LightVisibility& visible, int distance,
+                       float start, float end, const int* octant) {
+    if (start < end) return;
+
+    float nextStart = start;
+    for (int i = distance; i <= LIGHT_REACH; ++i) {
+        bool blocked = false;
+        for (int dx = -i, dy = -i; dx <= 0; ++dx) {
+            float leftSlope = (dx - 0.5f) / (dy + 0.5f);
+            float rightSlope = (dx + 0.5f) / (dy - 0.5f);
+            if (start < rightSlope) continue;
+            if (end > leftSlope) break;
+
+            int dCol = dx * octant[0] + dy * octant[1];
+            int dRow = dx * octant[2] + dy * octant[3];
+            if (dx * dx + dy * dy <= LIGHT_RADIUS * LIGHT_RADIUS) {
+                visible.rows[dRow + LIGHT_REACH] |= uint32_t(1) << (dCol + LIGHT_REACH);
+            }
+
+            bool wall = blocksLight(grid, light.row + dRow, light.col + dCol);
+            if (blocked) {
+                if (wall) {
+                    nextStart = rightSlope;
+                } else {
+                    blocked = false;
+                    start = nextStart;
+                }
+            } else if (wall && i < LIGHT_REACH) {
+                blocked = true;
+                castOctant(grid, light, visible, i + 1, start, leftSlope, octant);
+                nextStart = rightSlope;
+            }
+        }
+        if (blocked) break;
+    }
+}
+
+void castLight(const Grid& grid, const Cell& light, LightVisibility& visible) {
+    std::fill(visible.rows, visible.rows + 2 * LIGHT_REACH + 1, 0);
+    visible.rows[LIGHT_REACH] = uint32_t(1) << LIGHT_REACH;
+    for (int i = 0; i < 8; ++i) {
+        castOctant(grid, light, visible, 1, 1.0f, 0.0f, OCTANTS[i]);
+    }
+}
+
+void VisibilityCache::reset(int rows, int cols) {
+    bucketCols = (cols + LIGHT_BUCKET_SIZE - 1) / LIGHT_BUCKET_SIZE;
+    count = 0;
+    buckets.assign(static_cast<size_t>((rows + LIGHT_BUCKET_SIZE - 1) / LIGHT_BUCKET_SIZE) * bucketCols, std::vector<Entry>());
+}
+
+const LightVisibility& VisibilityCache::get(const Grid& grid, const Cell& light) {
+    std::vector<Entry>& bucket = bucketOf(light.row, light.col);
+    for (const Entry& entry : bucket) {
+        if (entry.light.row == light.row && entry.light.col == light.col) return entry.visible;
+    }
+
+    bucket.push_back(Entry{light, LightVisibility()});
+    castLight(grid, light, bucket.back().visible);
+    ++count;
+    return bucket.back().visible;
+}
+
+void VisibilityCache::invalidate(int row, int col) {
+    if (buckets.empty()) return;
+
+    int rowBegin = std::max(row - LIGHT_REACH, 0) / LIGHT_BUCKET_SIZE;
+    int colBegin = std::max(col - LIGHT_REACH, 0) / LIGHT_BUCKET_SIZE;
+    int rowEnd = std::min((row + LIGHT_REACH) / LIGHT_BUCKET_SIZE, static_cast<int>(buckets.size() / bucketCols) - 1);
+    int colEnd = std::min((col + LIGHT_REACH) / LIGHT_BUCKET_SIZE, bucketCols - 1);
+
+    for (int bucketRow = rowBegin; bucketRow <= rowEnd; ++bucketRow) {
+        for (int bucketCol = colBegin; bucketCol <= colEnd; ++bucketCol) {
+            std::vector<Entry>& bucket = buckets[static_cast<size_t>(bucketRow) * bucketCols + bucketCol];
+            for (size_t i = 0; i < bucket.size();) {
+                if (std::abs(bucket[i].light.row - row) <= LIGHT_REACH && std::abs(bucket[i].light.col - col) <= LIGHT_REACH) {
+                    bucket[i] = bucket.back();
+                    bucket.pop_back();
+                    --count;
+                } else {
+                    ++i;
+                }
+            }
+        }
+    }
+}
+
+LightMap::LightMap() : rowCount(0), colCount(0), grid(NULL) {
+    std::fill(disc, disc + 2 * LIGHT_REACH + 1, 0);
+    for (int dRow = -LIGHT_REACH; dRow <= LIGHT_REACH; ++dRow) {
+        for (int dCol = -LIGHT_REACH; dCol <= LIGHT_REACH; ++dCol) {
+            float distanceSquared = static_cast<float>(dRow * dRow + dCol * dCol);
+            stamp[dRow + LIGHT_REACH][dCol + LIGHT_REACH] = lightFalloff(distanceSquared);
+            if (distanceSquared <= LIGHT_RADIUS * LIGHT_RADIUS) disc[dRow + LIGHT_REACH] |= uint32_t(1) << (dCol + LIGHT_REACH);
+        }
+    }
+}
+
+void LightMap::build(const LightIndex& lights, const Grid& grid) {
+    this->grid = &grid;
+    rowCount = lights.rows();
+    colCount = lights.cols();
+    visibility.reset(rowCount, colCount);
+    brightness.assign(static_cast<size_t>(rowCount) * colCount, AMBIENT_BRIGHTNESS);
+    lights.forEachInBox(0, rowCount, 0, colCount, [this](const Cell& light) { addLight(light); });
+}
+
+void LightMap::addLight(const Cell& light) {
+    stampLight(light, 0, rowCount, 0, colCount);
+}
+
+void LightMap::relight(int rowBegin, int rowEnd, int colBegin, int colEnd, const LightIndex& lights) {
+    rowBegin = std::max(rowBegin, 0);
+    colBegin = std::max(colBegin, 0);
+    rowEnd = std::min(rowEnd, rowCount);
+    colEnd = std::min(colEnd, colCount);
+    if (rowBegin >= rowEnd || colBegin >= colEnd) return;
+
+    for (int row = rowBegin; row < rowEnd; ++row) {
+        std::fill(&brightness[static_cast<size_t>(row) * colCount + colBegin],
+                  &brightness[static_cast<size_t>(row) * colCount + colEnd], AMBIENT_BRIGHTNESS);
+    }
+    // Only lights within reach of the region can touch it
+    lights.forEachInBox(rowBegin - LIGHT_REACH, rowEnd + LIGHT_REACH, colBegin - LIGHT_REACH, colEnd + LIGHT_REACH,
+                        [&](const Cell& light) { stampLight(light, rowBegin, rowEnd, colBegin, colEnd); });
+}
+
+void LightMap::cellChanged(int row, int col, const LightIndex& lights) {
+    // Lights within reach of the cell may now see more or less, and they light up to
+    // LIGHT_REACH cells further out
+    visibility.invalidate(row, col);
+    relight(row - 2 * LIGHT_REACH, row + 2 * LIGHT_REACH + 1, col - 2 * LIGHT_REACH, col + 2 * LIGHT_REACH + 1, lights);
+}
+
+void LightMap::stampLight(const Cell& light, int clipRowBegin, int clipRowEnd, int clipColBegin, int clipColEnd) {
+    // Max-blend the light's stamp, clipped to the given region
+    int rowBegin = std::max(light.row - LIGHT_REACH, clipRowBegin);
+    int rowEnd = std::min(light.row + LIGHT_REACH + 1, clipRowEnd);
+    int colBegin = std::max(light.col - LIGHT_REACH, clipColBegin);
+    int colEnd = std::min(light.col + LIGHT_REACH + 1, clipColEnd);
+
+    if (colBegin >= colEnd) return;
+
+    const LightVisibility& visible = visibility.get(*grid, light);
+    for (int row = rowBegin; row < rowEnd; ++row) {
+        int dRow = row - light.row + LIGHT_REACH;
+        uint32_t bits = visible.rows[dRow];
+        if (bits == 0) continue;
+
+        // Shadowed cells get weight 0, which never wins against the ambient floor. Cells outside
+        // the disc only hold the ambient floor anyway, so a row that sees its whole disc needs no mask.
+        const float* weights = stamp[dRow];
+        float masked[2 * LIGHT_REACH + 1];
+        if ((bits & disc[dRow]) != disc[dRow]) {
+            for (int i = 0; i <= 2 * LIGHT_REACH; ++i) {
+                masked[i] = ((bits >> i) & 1) ? weights[i] : 0.0f;
+            }
+            weights = masked;
+        }
+        maxBlendRow(&brightness[static_cast<size_t>(row) * colCount + colBegin],
+                    weights + colBegin - light.col + LIGHT_REACH, colEnd - colBegin);
+    }
+}
+
+ShadeMap::ShadeMap(const LightMap& lightMap, int lightRow, int lightCol)
+    : lightMap(lightMap), rows(lightMap.rows()), cols(lightMap.cols()), lightRow(lightRow), lightCol(lightCol),
+      shades(static_cast<size_t>(rows) * cols) {
+    castLight(*lightMap.occluders(), Cell(lightRow, lightCol), lightVisible);
+    refreshAll();
+}
+
+void ShadeMap::moveLight(int row, int col) {
+    if (row == lightRow && col == lightCol) return;
+
+    // Cells outside both footprints keep the static shade either way
+    CellRect previous = footprint(lightRow, lightCol);
+    lightRow = row;
+    lightCol = col;
+    castLight(*lightMap.occluders(), Cell(row, col), lightVisible);
+    refresh(previous);
+    refresh(footprint(row, col));
+}
+
+void ShadeMap::refresh(const CellRect& region) {
+    CellRect clipped(std::max(region.rowBegin, 0), std::min(region.rowEnd, rows),
+                     std::max(region.colBegin, 0), std::min(region.colEnd, cols));
+    if (clipped.empty()) return;
+
+    for (int row = clipped.rowBegin; row < clipped.rowEnd; ++row) {
+        uint8_t* cells = &shades[static_cast<size_t>(row) * cols];
+        for (int col = clipped.colBegin; col < clipped.colEnd; ++col) {
+            cells[col] = static_cast<uint8_t>(255 * lightMap.litBy(row, col, lightRow, lightCol, &lightVisible));
+        }
+    }
+    dirtyRegions.push_back(clipped);
+}
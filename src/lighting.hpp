@@ -0,0 +1,216 @@
+// lighting.hpp
+#ifndef LIGHTING_H
+#define LIGHTING_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "mazegen.hpp"
+
+#define LIGHT_RADIUS 8.0f // Radius of light effect, in cells
+#define LIGHT_REACH 8 // LIGHT_RADIUS rounded down: cells further away along a row or column are never lit
+#define AMBIENT_BRIGHTNESS 0.05f // Brightness of an unlit cell
+#define LIGHT_BUCKET_SIZE 8 // Cells per side of a light index bucket
+
+// Brightness of a cell whose squared distance from a light is distanceSquared, ambient included.
+// Only d^2 enters the formula, so no square root is taken.
+float lightFalloff(float distanceSquared);
+
+// Uniform grid of buckets over the map holding light positions, so finding the lights that can
+// reach a cell only visits the buckets overlapping its radius instead of every light. Lights may
+// be inserted and removed at any time (torches, fireflies) and may share a cell.
+class LightIndex {
+public:
+    LightIndex() : rowCount(0), colCount(0), bucketRows(0), bucketCols(0), count(0) {}
+
+    // Clears the index and sizes it for a rows x cols map
+    void reset(int rows, int cols);
+    void build(int rows, int cols, const Cell* lights, size_t count);
+
+    // Lights must lie inside the map
+    void insert(const Cell& light);
+    // Removes one light at that cell; returns false if there is none
+    bool remove(const Cell& light);
+
+    int rows() const { return rowCount; }
+    int cols() const { return colCount; }
+    size_t size() const { return count; }
+
+    // Calls fn(light) for every light inside rows [rowBegin, rowEnd) and cols [colBegin, colEnd)
+    template <typename Fn>
+    void forEachInBox(int rowBegin, int rowEnd, int colBegin, int colEnd, Fn fn) const {
+        rowBegin = std::max(rowBegin, 0);
+        colBegin = std::max(colBegin, 0);
+        rowEnd = std::min(rowEnd, rowCount);
+        colEnd = std::min(colEnd, colCount);
+        if (rowBegin >= rowEnd || colBegin >= colEnd) return;
+
+        for (int bucketRow = rowBegin / LIGHT_BUCKET_SIZE; bucketRow <= (rowEnd - 1) / LIGHT_BUCKET_SIZE; ++bucketRow) {
+            for (int bucketCol = colBegin / LIGHT_BUCKET_SIZE; bucketCol <= (colEnd - 1) / LIGHT_BUCKET_SIZE; ++bucketCol) {
+                for (const Cell& light : buckets[static_cast<size_t>(bucketRow) * bucketCols + bucketCol]) {
+                    if (light.row >= rowBegin && light.row < rowEnd && light.col >= colBegin && light.col < colEnd) fn(light);
+                }
+            }
+        }
+    }
+
+    // Appends the lights within `radius` cells (Euclidean) of (row, col) to out
+    void query(int row, int col, float radius, std::vector<Cell>& out) const;
+
+private:
+    int rowCount;
+    int colCount;
+    int bucketRows;
+    int bucketCols;
+    size_t count;
+    std::vector<std::vector<Cell>> buckets; // Row-major, LIGHT_BUCKET_SIZE cells per side
+
+    std::vector<Cell>& bucketOf(const Cell& light) {
+        return buckets[static_cast<size_t>(light.row / LIGHT_BUCKET_SIZE) * bucketCols + light.col / LIGHT_BUCKET_SIZE];
+    }
+};
+
+// Cells within reach of a light that the light can see: bit (dCol + LIGHT_REACH) of
+// rows[dRow + LIGHT_REACH] is set when the cell at offset (dRow, dCol) is lit
+struct LightVisibility {
+    uint32_t rows[2 * LIGHT_REACH + 1];
+};
+
+// Recursive shadowcasting over the 8 octants around light, limited to LIGHT_RADIUS. PATH cells
+// let light through; every other cell, and everything outside the grid, blocks it but is lit
+// itself when the light reaches it. The light's own cell never blocks.
+void castLight(const Grid& grid, const Cell& light, LightVisibility& visible);
+
+// Visibility of every static light, computed on first use. An entry only goes stale when a cell
+// within reach of its light changes, so it is dropped by invalidate() rather than recomputed
+// per frame. Entries are bucketed like LightIndex, so lookups in map order stay cache friendly.
+class VisibilityCache {
+public:
+    VisibilityCache() : bucketCols(0), count(0) {}
+
+    // Clears the cache and sizes it for a rows x cols map
+    void reset(int rows, int cols);
+    // The returned reference is valid until the next get() or invalidate()
+    const LightVisibility& get(const Grid& grid, const Cell& light);
+    // Drops the entries of the lights within reach of (row, col); call when that cell changes
+    void invalidate(int row, int col);
+    size_t size() const { return count; }
+
+private:
+    struct Entry {
+        Cell light;
+        LightVisibility visible;
+    };
+
+    int bucketCols;
+    size_t count;
+    std::vector<std::vector<Entry>> buckets; // Row-major, LIGHT_BUCKET_SIZE cells per side
+
+    std::vector<Entry>& bucketOf(int row, int col) {
+        return buckets[static_cast<size_t>(row / LIGHT_BUCKET_SIZE) * bucketCols + col / LIGHT_BUCKET_SIZE];
+    }
+};
+
+// Brightness of every cell due to the static lights (the level's light cells). The map is built
+// once after decoration and patched locally when lights are added or removed; only the player's
+// light is added per frame, so the frame cost does not depend on how many lights there are.
+class LightMap {
+public:
+    LightMap();
+
+    // Rebuilds the whole map from the indexed lights, shadowed by the grid's walls. The grid must
+    // outlive the map and match the index's size.
+    void build(const LightIndex& lights, const Grid& grid);
+    // Adds one light (brightness only ever goes up, so nothing is recomputed)
+    void addLight(const Cell& light);
+    // Recomputes rows [rowBegin, rowEnd) and cols [colBegin, colEnd) from the lights that can
+    // reach them, e.g. after lights there were removed from the index
+    void relight(int rowBegin, int rowEnd, int colBegin, int colEnd, const LightIndex& lights);
+    // Recomputes the cells a light removed from the index used to reach
+    void removeLight(const Cell& light, const LightIndex& lights) {
+        relight(light.row - LIGHT_REACH, light.row + LIGHT_REACH + 1, light.col - LIGHT_REACH, light.col + LIGHT_REACH + 1, lights);
+    }
+    // Re-casts the lights that can see (row, col) after that grid cell changed, and relights
+    // everything they reach
+    void cellChanged(int row, int col, const LightIndex& lights);
+
+    const Grid* occluders() const { return grid; }
+
+    int rows() const { return rowCount; }
+    int cols() const { return colCount; }
+
+    // Static brightness of a cell
+    float at(int row, int col) const { return brightness[static_cast<size_t>(row) * colCount + col]; }
+
+    // Static brightness combined with a moving light at (lightRow, lightCol), capped at 1. When
+    // visible is given, the moving light only reaches the cells it marks.
+    float litBy(int row, int col, int lightRow, int lightCol, const LightVisibility* visible = NULL) const {
+        float value = at(row, col);
+        int dRow = row - lightRow + LIGHT_REACH;
+        int dCol = col - lightCol + LIGHT_REACH;
+        if (dRow >= 0 && dRow <= 2 * LIGHT_REACH && dCol >= 0 && dCol <= 2 * LIGHT_REACH &&
+            (!visible || ((visible->rows[dRow] >> dCol) & 1))) {
+            value = std::max(value, stamp[dRow][dCol]);
+        }
+        return std::min(value, 1.0f);
+    }
+
+private:
+    int rowCount;
+    int colCount;
+    std::vector<float> brightness;
+    const Grid* grid;
+    VisibilityCache visibility;
+
+    // lightFalloff for every offset within reach of a light
+    float stamp[2 * LIGHT_REACH + 1][2 * LIGHT_REACH + 1];
+    // Per stamp row, the bits of the cells within LIGHT_RADIUS
+    uint32_t disc[2 * LIGHT_REACH + 1];
+
+    void stampLight(const Cell& light, int clipRowBegin, int clipRowEnd, int clipColBegin, int clipColEnd);
+};
+
+// Rows [rowBegin, rowEnd) and cols [colBegin, colEnd) of a map
+struct CellRect {
+    int rowBegin, rowEnd, colBegin, colEnd;
+    CellRect(int rowBegin, int rowEnd, int colBegin, int colEnd)
+        : rowBegin(rowBegin), rowEnd(rowEnd), colBegin(colBegin), colEnd(colEnd) {}
+    bool empty() const { return rowBegin >= rowEnd || colBegin >= colEnd; }
+};
+
+// Final shade (0-255) of every cell: the static lightmap with the player's light on top, shadowed
+// by the same walls. Moving the light only recomputes the union of its old and new footprints,
+// so the per-frame cost depends on the light radius, not on the map size.
+class ShadeMap {
+public:
+    ShadeMap(const LightMap& lightMap, int lightRow, int lightCol);
+
+    // Moves the player's light; dirty() then lists the regions whose shade was recomputed
+    void moveLight(int row, int col);
+    // Recomputes a region after the lightmap changed there (or everything, for refreshAll)
+    void refresh(const CellRect& region);
+    void refreshAll() { refresh(CellRect(0, rows, 0, cols)); }
+
+    uint8_t shade(int row, int col) const { return shades[static_cast<size_t>(row) * cols + col]; }
+
+    // Regions recomputed since the last clearDirty(), possibly overlapping
+    const std::vector<CellRect>& dirty() const { return dirtyRegions; }
+    void clearDirty() { dirtyRegions.clear(); }
+
+private:
+    const LightMap& lightMap;
+    int rows;
+    int cols;
+    int lightRow;
+    int lightCol;
+    LightVisibility lightVisible; // Cast once per move, not per frame
+    std::vector<uint8_t> shades;
+    std::vector<CellRect> dirtyRegions;
+
+    CellRect footprint(int row, int col) const {
+        return CellRect(row - LIGHT_REACH, row + LIGHT_REACH + 1, col - LIGHT_REACH, col + LIGHT_REACH + 1);
+    }
+};
+
+#endif // LIGHTING_H
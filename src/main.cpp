@@ -1,144 +1,95 @@
-#include "mazegen.hpp"
-#include "spider.hpp"
-#include "tree.hpp"
-
-#define MOVE_DURATION 60000 // Duration of player movement in microseconds
-
-// Function to find the first open cell (PATH) from the bottom-left of the grid
-sf::Vector2f findStartingPosition(const std::vector<std::vector<int>>& gridColors, int rows, int cols) {  //BFS
-    std::queue<Cell> q;
-    q.push(Cell(rows - 1, 0)); // Start from the bottom-left corner
+// main.cpp
+// SFML frontend: polls the keyboard into a SimInput, steps the simulation once per frame and draws
+// its render description through a camera that follows the player.
 
-    while (!q.empty()) {
-        Cell current = q.front();
-        q.pop();
+#include "sim.hpp"
+#include "tilemap.hpp"
+#include "tree.hpp"
 
-        if (gridColors[current.row][current.col] == PATH) {
-            return sf::Vector2f(current.col * GRID_SPACING, current.row * GRID_SPACING);
-        }
+#define MAP_SCALE 4 // Default map size, in windows across and down
+#define TREE_VARIANTS 6 // Trees cycle through this many shapes (lengths repeat every 3, depths every 2)
 
-        std::vector<Cell> neighbors = {
-            {current.row - 1, current.col}, 
-            {current.row + 1, current.col}, 
-            {current.row, current.col - 1}, 
-            {current.row, current.col + 1}  
-        };
+sf::Vector2f toSf(const Vec2& point) {
+    return sf::Vector2f(point.x, point.y);
+}
 
-        for (const Cell& neighbor : neighbors) {
-            if (neighbor.isInsideGrid(rows, cols)) {
-                q.push(neighbor);
-            }
-        }
+// Root of every tree in the simulation's window, in map pixels. Trees come in row-major order, so
+// the trees of window row r are level.trees[rowStart[r]] up to rowStart[r + 1], sorted by column;
+// the trees in view are found without scanning the window.
+void indexTrees(const Level& level, const RenderFrame& frame, std::vector<sf::Vector2f>& roots, std::vector<size_t>& rowStart) {
+    roots.clear();
+    for (const Cell& tree : level.trees) {
+        roots.push_back(sf::Vector2f((frame.windowCol + tree.col) * GRID_SPACING + GRID_SPACING / 2,
+                                     (frame.windowRow + tree.row) * GRID_SPACING));
+    }
+    rowStart.assign(level.grid.rows() + 1, 0);
+    for (const Cell& tree : level.trees) {
+        ++rowStart[tree.row + 1];
+    }
+    for (int row = 0; row < level.grid.rows(); ++row) {
+        rowStart[row + 1] += rowStart[row];
     }
-    // Default to top-left if no open cell is found
-    return sf::Vector2f(0, 0);
 }
 
-int main() {
-    sf::RenderWindow window(sf::VideoMode(800, 800), "Maze spider");
-
-    int rows = window.getSize().y / GRID_SPACING;
-    int cols = window.getSize().x / GRID_SPACING;
-
-    std::vector<std::vector<int>> gridColors(rows, std::vector<int>(cols, 0));
-
-    srand(static_cast<unsigned>(time(0)));
-
-    // ------------------------------------ Cellular Automata Maze Generation ------------------------------------
-    MazeGenerator* generator = new CellularAutomataGenerator(WALL_PROBABILITY, CA_STEPS);
-
-    // ------------------------------------ Drunk Walk Maze Generation ------------------------------------
-    // MazeGenerator* generator = new DrunkWalkGenerator(DRUNK_WALK_STEPS);
-
-    // ------------------------------------ Prim's Maze Generation ------------------------------------
-    // MazeGenerator* generator = new PrimGenerator();
-
-    // ------------------------------------ L-System Maze Generation ------------------------------------
-    // MazeGenerator* generator = new LSystemGenerator(L_SYSTEM_ITERATIONS, L_SYSTEM_STARTPOINTS);
-
-
-    generator->generateMaze(gridColors, rows, cols);
-    std::cout << "Maze generated!" << std::endl;
-
-    // with 1.25% chance, make a wall a light
-    for (int row = 0; row < rows; ++row) {
-        for (int col = 0; col < cols; ++col) {
-            if (gridColors[row][col] == WALL && rand() % 80 == 0) {
-                gridColors[row][col] = LIGHT;
-            }
-        }
-    }
+// Centers the camera on target without showing anything past the edges of the map; a map smaller
+// than the view is centered instead
+void followPlayer(sf::View& camera, const sf::Vector2f& target, const sf::Vector2f& mapSize) {
+    sf::Vector2f half = camera.getSize() / 2.0f;
+    sf::Vector2f center = target;
+    center.x = mapSize.x <= 2 * half.x ? mapSize.x / 2 : std::min(std::max(center.x, half.x), mapSize.x - half.x);
+    center.y = mapSize.y <= 2 * half.y ? mapSize.y / 2 : std::min(std::max(center.y, half.y), mapSize.y - half.y);
+    camera.setCenter(center);
+}
 
-    sf::Texture wallTexture;
-    if(!wallTexture.loadFromFile("assets/grey-wall.png")) {
-        std::cerr << "Failed to load wall texture!" << std::endl;
+int main(int argc, char* argv[]) {
+    // Rows and cols come as a pair; one without the other would be silently ignored
+    if (argc == 3 || argc > 4) {
+        std::cerr << "Usage: " << argv[0] << " [seed [rows cols]]" << std::endl;
         return 1;
     }
 
-    sf::Texture surfaceTexture;
-    if(!surfaceTexture.loadFromFile("assets/grey-surface.png")) {
-        std::cerr << "Failed to load surface texture!" << std::endl;
-        return 1;
-    }
+    // Optional seed argument; the same seed reproduces the same maze, lights and trees
+    uint64_t seed = argc > 1 ? std::strtoull(argv[1], NULL, 10) : static_cast<uint64_t>(time(0));
+    std::cout << "Seed: " << seed << std::endl;
 
-    sf::Texture backgroundTexture;
-    if(!backgroundTexture.loadFromFile("assets/background.png")) {
-        std::cerr << "Failed to load background texture!" << std::endl;
-        return 1;
-    }
+    sf::RenderWindow window(sf::VideoMode(800, 800), "Maze spider");
 
-    sf::Texture lightTexture;
-    if(!lightTexture.loadFromFile("assets/light2.png")) {
-        std::cerr << "Failed to load light texture!" << std::endl;
+    // Optional map size in cells after the seed; the camera scrolls over maps larger than the window
+    int rows = argc > 3 ? std::atoi(argv[2]) : MAP_SCALE * window.getSize().y / GRID_SPACING;
+    int cols = argc > 3 ? std::atoi(argv[3]) : MAP_SCALE * window.getSize().x / GRID_SPACING;
+    if (rows <= 0 || cols <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [seed [rows cols]]" << std::endl;
         return 1;
     }
-
-    wallTexture.setSmooth(true);
-    surfaceTexture.setSmooth(true);
-    backgroundTexture.setSmooth(true);
-    lightTexture.setSmooth(true);
-
-    sf::Sprite wallSprite;
-    wallSprite.setTexture(wallTexture);
-    wallSprite.setScale(
-        GRID_SPACING / static_cast<float>(wallSprite.getTexture()->getSize().x),
-        GRID_SPACING / static_cast<float>(wallSprite.getTexture()->getSize().y)
-    );
-
-    sf::Sprite surfaceSprite;
-    surfaceSprite.setTexture(surfaceTexture);
-    surfaceSprite.setScale(
-        GRID_SPACING / static_cast<float>(surfaceSprite.getTexture()->getSize().x),
-        GRID_SPACING / static_cast<float>(surfaceSprite.getTexture()->getSize().y)
-    );
-
-    sf::Sprite backgroundSprite;
-    backgroundSprite.setTexture(backgroundTexture);
-    backgroundSprite.setScale(
-        GRID_SPACING / static_cast<float>(backgroundSprite.getTexture()->getSize().x),
-        GRID_SPACING / static_cast<float>(backgroundSprite.getTexture()->getSize().y)
-    );
-
-    sf::Sprite lightSprite;
-    lightSprite.setTexture(lightTexture);
-    lightSprite.setScale(
-        GRID_SPACING / static_cast<float>(lightSprite.getTexture()->getSize().x),
-        GRID_SPACING / static_cast<float>(lightSprite.getTexture()->getSize().y)
-    );
-
-    std::vector<sf::Vector2f> lightSources;
-    for (int row = 0; row < rows; ++row) {
-        for (int col = 0; col < cols; ++col) {
-            if (gridColors[row][col] == LIGHT) {
-                lightSources.emplace_back(col, row);
-            }
+    std::cout << "Map: " << rows << " x " << cols << " cells" << std::endl;
+
+    // Chunks are generated around the player on a background thread as the player moves
+    std::unique_ptr<ChunkWorld> world = createWorld(seed);
+    Simulation sim(*world, rows, cols, hardwareThreads());
+
+    // All tiles share one atlas texture, so the grid draws in a single call
+    TextureAtlas atlas;
+    int tileTextures[TILE_KINDS];
+    tileTextures[TILE_WALL] = atlas.add("assets/grey-wall.png");
+    tileTextures[TILE_SURFACE] = atlas.add("assets/grey-surface.png");
+    tileTextures[TILE_BACKGROUND] = atlas.add("assets/background.png");
+    tileTextures[TILE_LIGHT] = atlas.add("assets/light2.png");
+    for (int kind = 0; kind < TILE_KINDS; ++kind) {
+        if (tileTextures[kind] < 0) {
+            std::cerr << "Failed to load tile texture!" << std::endl;
+            return 1;
         }
     }
+    if (!atlas.pack()) {
+        std::cerr << "Failed to pack tile atlas!" << std::endl;
+        return 1;
+    }
+    atlas.texture().setSmooth(true);
 
     // -------------------------------make the whole maze a path---------------------------------------
     // for (int row = 1; row < rows - 1; ++row) {
     //     for (int col = 1; col < cols - 1; ++col) {
-    //         gridColors[row][col] = PATH;
+    //         level.grid[row][col] = PATH;
     //     }
     // }
 
@@ -146,33 +97,8 @@ int main() {
     //------------------------------------Tree----------------------------------------------------------
 
     std::vector<sf::Vector2f> treeGridArray; 
-
-    for (int row = 2; row < rows; ++row) { 
-        for (int col = 1; col < cols - 1; ++col) { 
-            if (gridColors[row][col] == WALL) {
-                bool validPosition = 
-                    gridColors[row - 1][col] == PATH &&
-                    gridColors[row - 1][col - 1] == PATH &&
-                    gridColors[row - 1][col + 1] == PATH &&
-                    gridColors[row - 2][col] == PATH &&
-                    gridColors[row - 2][col - 1] == PATH &&
-                    gridColors[row - 2][col + 1] == PATH;
-
-                if (validPosition) {
-                    if (validPosition && (rand() % 5 == 0)) { // Randomly decide whether to add the tree
-                        treeGridArray.push_back(sf::Vector2f(col * GRID_SPACING + GRID_SPACING / 2, row * GRID_SPACING));
-
-                        lightSources.emplace_back(col - 1, row);
-                        lightSources.emplace_back(col + 1, row);
-                        lightSources.emplace_back(col, row - 1);
-                        lightSources.emplace_back(col - 1, row - 1);
-                        lightSources.emplace_back(col + 1, row - 1);
-
-                    }
-                }
-            }
-        }
-    }
+    std::vector<size_t> treeRowStart;
+    indexTrees(sim.level(), sim.frame(), treeGridArray, treeRowStart);
 
     sf::Vector2f rootPosition;
     // Root position for the tree
@@ -181,24 +107,51 @@ int main() {
         printf("Root position: %f, %f\n", rootPosition.x, rootPosition.y);
 
     }
+
     // sf::Vector2f rootPosition(treeGridArray[0]);
 
     // Parameters for the tree
     float swayAmplitude = 10.0f; // Amplitude of sway in degrees
     float swaySpeed = 1.5f; // Speed of sway
-    sf::Clock clock;
+    sf::Clock clock; // Time since the last simulation step
+    TreeBatch forest; // Every tree in view, refilled and drawn once per frame
+
+    // Vary parameters slightly for each tree; variants follow the tree's map cell, so a tree keeps
+    // its shape when the window moves
+    float initialLength = 17.0f;
+    int maxDepth = 4; // Number of levels in the tree
+    std::vector<TreeSkeleton> treeVariants;
+    for (int variant = 0; variant < TREE_VARIANTS; ++variant) {
+        float lengthVariation = initialLength + (variant % 3) * 2.0f;
+        int depthVariation = maxDepth + (variant % 2);
+        int branchingVariation = 2 + variant % 2;
+        treeVariants.push_back(TreeSkeleton(lengthVariation, 90, depthVariation, branchingVariation));
+    }
 
 
     // ------------------------------------ Player Movement ------------------------------------
     sf::RectangleShape player(sf::Vector2f(GRID_SPACING, GRID_SPACING));
     player.setFillColor(sf::Color::Red);
 
-    sf::Vector2f playerPos = findStartingPosition(gridColors, rows, cols);
+    const ConnectivityIndex& connectivity = sim.connectivity();
+    if (connectivity.largestComponent() >= 0) {
+        std::cout << "Caves: " << connectivity.componentCount() << ", largest "
+                  << connectivity.componentSize(connectivity.largestComponent()) << " cells, "
+                  << connectivity.maxDistance() << " steps across" << std::endl;
+    }
+
+    sf::Vector2f playerPos = toSf(sim.frame().player);
     player.setPosition(playerPos);
 
     std::cout << "Player starting position: " << playerPos.x << ", " << playerPos.y << std::endl;
 
-    bool isFalling = false;
+    TileMap tileMap(atlas, tileTextures, GRID_SPACING);
+    tileMap.build(sim.level().grid, sim.shades(), sim.frame().windowRow, sim.frame().windowCol);
+    unsigned windowVersion = sim.frame().windowVersion;
+
+    // The camera follows the player; everything is drawn in map coordinates through it
+    sf::View camera(sf::FloatRect(0, 0, window.getSize().x, window.getSize().y));
+    sf::Vector2f mapSize(cols * GRID_SPACING, rows * GRID_SPACING);
 
     while (window.isOpen()) {
         sf::Event event;
@@ -206,191 +159,50 @@ int main() {
             if (event.type == sf::Event::Closed)
                 window.close();
         }
-        // Linearly interpolate the position between old and new, such that speed is equal to 10000us
-        static sf::Vector2f startPos;
-        static sf::Vector2f endPos;
-        static bool isMoving = false;
-        static sf::Clock moveClock, droneWalkTimer;
-        static float droneWalkInterval = 2.0f;
-        static int droneMoving = 0;
-        const sf::Time moveDuration = sf::microseconds(MOVE_DURATION);
-
-        static float fallingSpeed = 0.0f; // Initialize falling speed
-        const float GRAVITY = 0.01f; // Gravity acceleration per frame
-        const float TERM_VELO = 5.0f; // Maximum falling speed
-        const float LIGHT_RADIUS = 8.0f; // Radius of light effect
-        
 
         // ---------------------------------------- Player Movement ----------------------------------------
-        if (!isMoving) {
-            sf::Vector2f playerNewPos = player.getPosition();
-
-            bool keyPressed = false;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::W) && sf::Keyboard::isKeyPressed(sf::Keyboard::A) && !isFalling) {
-                playerNewPos.y -= GRID_SPACING;
-                playerNewPos.x -= GRID_SPACING;
-                keyPressed = true;
-            } else if (sf::Keyboard::isKeyPressed(sf::Keyboard::W) && sf::Keyboard::isKeyPressed(sf::Keyboard::D) && !isFalling) {
-                playerNewPos.y -= GRID_SPACING;
-                playerNewPos.x += GRID_SPACING;
-                keyPressed = true;
-            } else if (sf::Keyboard::isKeyPressed(sf::Keyboard::S) && sf::Keyboard::isKeyPressed(sf::Keyboard::A)) {
-                playerNewPos.y += GRID_SPACING;
-                playerNewPos.x -= GRID_SPACING;
-                keyPressed = true;
-            } else if (sf::Keyboard::isKeyPressed(sf::Keyboard::S) && sf::Keyboard::isKeyPressed(sf::Keyboard::D)) {
-                playerNewPos.y += GRID_SPACING;
-                playerNewPos.x += GRID_SPACING;
-                keyPressed = true;
-            } else if (sf::Keyboard::isKeyPressed(sf::Keyboard::W) && !isFalling) {
-                playerNewPos.y -= GRID_SPACING;
-                keyPressed = true;
-            } else if (sf::Keyboard::isKeyPressed(sf::Keyboard::S)) {
-                playerNewPos.y += GRID_SPACING;
-                keyPressed = true;
-            } else if (sf::Keyboard::isKeyPressed(sf::Keyboard::A)) {
-                playerNewPos.x -= GRID_SPACING;
-                keyPressed = true;
-            } else if (sf::Keyboard::isKeyPressed(sf::Keyboard::D)) {
-                playerNewPos.x += GRID_SPACING;
-                keyPressed = true;
-            }
-
-            int newRow = static_cast<int>(playerNewPos.y / GRID_SPACING);
-            int newCol = static_cast<int>(playerNewPos.x / GRID_SPACING);
-
-            if (keyPressed && isInBounds(newRow, newCol, rows, cols) && gridColors[newRow][newCol] != WALL && gridColors[newRow][newCol] != LIGHT) {
-                startPos = player.getPosition();
-                endPos = sf::Vector2f(newCol * GRID_SPACING, newRow * GRID_SPACING);
-                moveClock.restart();
-                isMoving = true;
-            }
-        }
-
-        if (isMoving) {
-            float t = moveClock.getElapsedTime().asMicroseconds() / static_cast<float>(moveDuration.asMicroseconds());
-            if (t >= 1.f) {
-                t = 1.f;
-                isMoving = false;
-            }
-            sf::Vector2f currentPos = startPos + t * (endPos - startPos);
-            player.setPosition(currentPos);
-        }
-
-        std::vector<Limb> limbs;
-        std::vector<sf::Vector2f> hexagonPoints = getHexagonalPoints(player.getPosition());
-
-        // ---------------------------------- Limb and Limb Guidelines Animation ----------------------------------
-        for (const auto& point : hexagonPoints) {
-            sf::Vector2f direction = point - player.getPosition() + sf::Vector2f(GRID_SPACING / 2, GRID_SPACING / 2);
-            sf::Vector2f wallPos = findClosestWall(player.getPosition() + sf::Vector2f(GRID_SPACING / 2, GRID_SPACING / 2), direction, gridColors, rows, cols);
-            limbs.emplace_back(player.getPosition() + sf::Vector2f(GRID_SPACING / 2, GRID_SPACING / 2), wallPos);
+        SimInput input;
+        input.up = sf::Keyboard::isKeyPressed(sf::Keyboard::W);
+        input.down = sf::Keyboard::isKeyPressed(sf::Keyboard::S);
+        input.left = sf::Keyboard::isKeyPressed(sf::Keyboard::A);
+        input.right = sf::Keyboard::isKeyPressed(sf::Keyboard::D);
+
+        // One simulation step per frame: movement, limbs, falling and the player's light
+        sim.step(input, clock.restart().asSeconds());
+        const RenderFrame& frame = sim.frame();
+        player.setPosition(toSf(frame.player));
+
+        if (frame.windowVersion != windowVersion) {
+            // The simulation moved its window: tiles and trees are rebuilt from the new one
+            windowVersion = frame.windowVersion;
+            tileMap.build(sim.level().grid, sim.shades(), frame.windowRow, frame.windowCol);
+            indexTrees(sim.level(), frame, treeGridArray, treeRowStart);
+        } else {
+            // Only the cells around the player's old and new position are recolored
+            tileMap.updateShades(sim.shades());
         }
 
         sf::VertexArray guideLines(sf::Lines);
-        for (const auto& point : hexagonPoints) {
+        for (const Vec2& point : frame.hexagonPoints) {
             guideLines.append(sf::Vertex(player.getPosition() + sf::Vector2f(player.getSize().x / 2, player.getSize().y / 2), sf::Color(225,135, 0)));
-            guideLines.append(sf::Vertex(point, sf::Color(225, 135, 0))); // Orange color
+            guideLines.append(sf::Vertex(toSf(point), sf::Color(225, 135, 0))); // Orange color
         }
 
-        for (Limb& limb : limbs) {
-            limb.animate(1.f); // Animate the limb
-        }
-
-        // ---------------------------------------- Falling ----------------------------------------
-        // Count active limbs
-        int activeLimbs = 0;
-        for (const auto& limb : limbs) {
-            if (limb.active) {
-                activeLimbs++;
-            }
-        }
-        if (activeLimbs == 0) {
-            // No limbs connected: full GRAVITY
-            fallingSpeed += GRAVITY;
-            isFalling = true;
-        } else if (activeLimbs < 3) {
-            // Less than 3 limbs: scaled GRAVITY
-            fallingSpeed += GRAVITY / activeLimbs;
-            isFalling = true;
-        } else {
-            fallingSpeed = 0.0f;
-            isFalling = false;
-        }
-        if (fallingSpeed > TERM_VELO) {
-            fallingSpeed = TERM_VELO;
-        }
-        player.move(0, fallingSpeed);
-
-        // Prevent the player from falling below the grid
-        if (player.getPosition().y > rows * GRID_SPACING) {
-            player.setPosition(player.getPosition().x, rows * GRID_SPACING - GRID_SPACING);
-            fallingSpeed = 0.0f; // Reset falling speed
-            isFalling = false;
-        }
-
-        int playerPosition_x = static_cast<int>(player.getPosition().x / GRID_SPACING);
-        int playerPosition_y = static_cast<int>(player.getPosition().y / GRID_SPACING);
-
         // ---------------------------------------- Drawing ----------------------------------------
+        followPlayer(camera, player.getPosition() + sf::Vector2f(GRID_SPACING / 2, GRID_SPACING / 2), mapSize);
+        window.setView(camera);
+        // Trees overhang their cell, so they are culled against the view plus VIEW_MARGIN
+        CellRect inView = visibleCells(camera, GRID_SPACING, rows, cols);
+
         window.clear(sf::Color::White);
 
-        for (int row = 0; row < rows; ++row) {
-            for (int col = 0; col < cols; ++col) {
-                sf::Sprite cellSprite;
-
-                if (gridColors[row][col] == WALL) {
-                    cellSprite = (row > 0 && (gridColors[row - 1][col] == WALL || gridColors[row - 1][col] == LIGHT))
-                                    ? wallSprite
-                                    : surfaceSprite;
-                } else if (gridColors[row][col] == PATH) {
-                    cellSprite = backgroundSprite;
-                } else if (gridColors[row][col] == LIGHT) {
-                    cellSprite = lightSprite;
-                }
-
-                // Calculate attenuation based on light sources
-                float lightbrightness = 0.05f; 
-
-                for (const auto& lightPos : lightSources) { // `lightSources` contains all light positions
-                    float localbrightness = 0.05f;
-                    float dx = col - lightPos.x;
-                    float dy = row - lightPos.y;
-                    float distance = std::sqrt(dx * dx + dy * dy);
-
-                    if (distance <= LIGHT_RADIUS) {
-                        localbrightness += 1.0f / (1.4f + (distance / LIGHT_RADIUS) * (distance / LIGHT_RADIUS));   // Attenuation formula, contribution of one light source
-                    }
-                    lightbrightness = std::max(lightbrightness, localbrightness);   // Use the maximum brightness
-                }
-
-                float playerbrightness = 0.05f;
-
-                // Include the player's light effect
-                float playerDx = col - playerPosition_x; 
-                float playerDy = row - playerPosition_y;
-                float playerDistance = std::sqrt(playerDx * playerDx + playerDy * playerDy);
-
-                if (playerDistance <= LIGHT_RADIUS) {
-                    playerbrightness += 1.0f / (1.4f + (playerDistance / LIGHT_RADIUS) * (playerDistance / LIGHT_RADIUS));
-                }
-
-                float brightness = std::max(lightbrightness, playerbrightness); // Use the maximum brightness
-                brightness = std::min(brightness, 1.0f); // Cap brightness to a maximum of 1.0
-
-                // Adjust the sprite's color based on the brightness
-                sf::Color color = sf::Color(255 * brightness, 255 * brightness, 255 * brightness);
-                cellSprite.setColor(color);
-
-                cellSprite.setPosition(col * GRID_SPACING, row * GRID_SPACING);
-                window.draw(cellSprite);
-            }
-        }
+        // The tiles under the camera from one persistent vertex array in a single draw call
+        window.draw(tileMap);
 
         // window.draw(guideLines);
         window.draw(player);
 
-        for (const auto& point : hexagonPoints) {
+        for (const Vec2& point : frame.hexagonPoints) {
             sf::CircleShape circle(CIRCLE_RADIUS);
             circle.setFillColor(sf::Color::Blue);
             circle.setPosition(point.x - CIRCLE_RADIUS, point.y - CIRCLE_RADIUS);
@@ -398,35 +210,52 @@ int main() {
         }
 
         sf::VertexArray limbLines(sf::Lines);
-        for (const auto& limb : limbs) {
+        for (const auto& limb : frame.limbs) {
             if(!limb.active) continue;
-            limbLines.append(sf::Vertex(limb.start, sf::Color::Red));
-            limbLines.append(sf::Vertex(limb.end, sf::Color::Red));
+            limbLines.append(sf::Vertex(toSf(limb.start), sf::Color::Red));
+            limbLines.append(sf::Vertex(toSf(limb.end), sf::Color::Red));
         }
         window.draw(limbLines);
         
 
         // -------------------------------------------Tree-------------------------------------------------------
 
-        float initialLength = 17.0f;
-        int maxDepth = 4; // Number of levels in the tree
-        int branchingFactor = 2; // Number of branches at each node
-
-        for (size_t i = 0; i < treeGridArray.size(); ++i) {
-            // Vary parameters slightly for each tree
-            float lengthVariation = initialLength + (i % 3) * 2.0f;
-            int depthVariation = maxDepth + (i % 2);
-            int branchingVariation = 2 + i%2;
-
-            // Calculate sway offset based on time
-            float time = clock.getElapsedTime().asSeconds();
-            float swayOffset = swayAmplitude * sin(time * swaySpeed + i * 0.1f);
-
-            drawIKTree(window, treeGridArray[i], lengthVariation, 90, depthVariation, branchingVariation, swayOffset, time);
+        // Calculate sway offset based on simulated time
+        float time = frame.time;
+        sf::Vector2f focus = player.getPosition() + sf::Vector2f(GRID_SPACING / 2, GRID_SPACING / 2);
+
+        // The view in window cells
+        const std::vector<Cell>& trees = sim.level().trees;
+        int windowRows = sim.level().grid.rows();
+        int colBegin = inView.colBegin - frame.windowCol;
+        int colEnd = inView.colEnd - frame.windowCol;
+
+        forest.clear();
+        for (int row = std::max(inView.rowBegin - frame.windowRow, 0); row < std::min(inView.rowEnd - frame.windowRow, windowRows); ++row) {
+            // First tree of the row inside the view, by binary search on its column
+            size_t i = treeRowStart[row];
+            size_t rowEnd = treeRowStart[row + 1];
+            i = std::lower_bound(trees.begin() + i, trees.begin() + rowEnd, colBegin,
+                                 [](const Cell& tree, int col) { return tree.col < col; }) - trees.begin();
+            for (; i < rowEnd && trees[i].col < colEnd; ++i) {
+                unsigned id = static_cast<unsigned>(frame.windowRow + trees[i].row) * 31u + (frame.windowCol + trees[i].col);
+                float swayOffset = swayAmplitude * sin(time * swaySpeed + (id % 1024) * 0.1f);
+
+                // Level of detail: the further the tree is from the player, the longer a branch
+                // must be to be drawn
+                const TreeSkeleton& skeleton = treeVariants[id % TREE_VARIANTS];
+                sf::Vector2f offset = treeGridArray[i] - focus;
+                float distance = std::sqrt(offset.x * offset.x + offset.y * offset.y);
+                int levels = skeleton.levelsFor(TREE_LOD_MIN_LENGTH * (1.0f + distance / TREE_LOD_DISTANCE));
+
+                forest.addTree(skeleton, treeGridArray[i], swayOffset, time, levels);
+            }
         }
+        window.draw(forest);
 
         window.display();
     }
 
+    world->printStats(std::cout);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,186 @@
+// mazebench.cpp
+// Headless generator benchmark: runs every generator over a sweep of grid sizes and seeds and
+// reports cells/second, peak RSS, heap allocations and per-phase wall time as a table and JSON.
+//
+//   mazebench [--sizes 256,1024,4096] [--seeds 3] [--threads N] [--json results.json]
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mazegen.hpp"
+
+// ------------------------------------ Allocation counting ------------------------------------
+static std::atomic<uint64_t> allocationCount(0);
+static std::atomic<uint64_t> allocationBytes(0);
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    void* memory = std::malloc(size ? size : 1);
+    if (!memory) throw std::bad_alloc();
+    return memory;
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+// ------------------------------------ Benchmark ------------------------------------
+#define BENCH_PHASE_SLOTS 16 // More distinct phases than any generator reports
+
+struct BenchResult {
+    std::string generator;
+    int size;
+    uint64_t seed;
+    double seconds;
+    long peakRss;
+    uint64_t allocations;
+    uint64_t allocatedBytes;
+    double pathFraction;
+    PhaseTimes phases;
+};
+
+static MazeGenerator* makeGenerator(int kind, int threads) {
+    switch (kind) {
+        case GENERATOR_CELLULAR_AUTOMATA: return new CellularAutomataGenerator(WALL_PROBABILITY, CA_STEPS, threads);
+        case GENERATOR_PRIM: return new PrimGenerator();
+        case GENERATOR_DRUNK_WALK: return new DrunkWalkGenerator(DRUNK_WALK_STEPS, DRUNK_WALK_WALKERS, threads);
+        default: return new LSystemGenerator(L_SYSTEM_ITERATIONS, L_SYSTEM_STARTPOINTS, threads);
+    }
+}
+
+static BenchResult runOnce(int kind, int size, uint64_t seed, int threads) {
+    BenchResult result;
+    result.generator = generatorName(kind);
+    result.size = size;
+    result.seed = seed;
+
+    MazeGenerator* generator = makeGenerator(kind, threads);
+    generator->setSeed(seed);
+    generator->setPhaseTimes(&result.phases);
+
+    // Room for every phase up front, so recording a phase does not count as a generator allocation
+    result.phases.reserve(BENCH_PHASE_SLOTS);
+
+    resetPeakRss();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    Grid grid;
+    {
+        ScopedPhase phase(&result.phases, "alloc");
+        grid.resize(size, size, WALL);
+    }
+
+    // Allocations are counted for the generator alone; the grid it fills is allocated above
+    uint64_t allocationsBefore = allocationCount.load();
+    uint64_t bytesBefore = allocationBytes.load();
+    generator->generateMaze(grid);
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.allocations = allocationCount.load() - allocationsBefore;
+    result.allocatedBytes = allocationBytes.load() - bytesBefore;
+    result.peakRss = peakRssKb();
+
+    // Also keeps the generated grid observable so the work cannot be optimised away
+    size_t paths = 0;
+    for (size_t i = 0; i < grid.size(); ++i) paths += grid.data()[i] == PATH;
+    result.pathFraction = grid.size() ? static_cast<double>(paths) / grid.size() : 0.0;
+
+    delete generator;
+    return result;
+}
+
+static void printRow(const BenchResult& result) {
+    double cells = static_cast<double>(result.size) * result.size;
+    std::ostringstream phases;
+    phases << std::fixed << std::setprecision(2);
+    for (const auto& phase : result.phases.entries()) {
+        phases << phase.first << '=' << phase.second * 1000.0 << "ms ";
+    }
+    std::printf("%-10s %6d %6llu %10.2f %10.2f %9.1f %8llu %9.1f %6.3f  %s\n",
+                result.generator.c_str(), result.size, static_cast<unsigned long long>(result.seed),
+                result.seconds * 1000.0, cells / result.seconds / 1e6, result.peakRss / 1024.0,
+                static_cast<unsigned long long>(result.allocations), result.allocatedBytes / (1024.0 * 1024.0),
+                result.pathFraction, phases.str().c_str());
+}
+
+static void writeJson(std::ostream& out, const std::vector<BenchResult>& results, int threads) {
+    out << "{\n  \"threads\": " << threads << ",\n  \"runs\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& result = results[i];
+        double cells = static_cast<double>(result.size) * result.size;
+        out << "    {\"generator\": \"" << result.generator << "\", \"size\": " << result.size
+            << ", \"seed\": " << result.seed << ", \"seconds\": " << result.seconds
+            << ", \"cellsPerSecond\": " << cells / result.seconds << ", \"peakRssKb\": " << result.peakRss
+            << ", \"allocations\": " << result.allocations << ", \"allocatedBytes\": " << result.allocatedBytes
+            << ", \"pathFraction\": " << result.pathFraction << ", \"phases\": {";
+        for (size_t p = 0; p < result.phases.entries().size(); ++p) {
+            const auto& phase = result.phases.entries()[p];
+            out << (p ? ", " : "") << '"' << phase.first << "\": " << phase.second;
+        }
+        out << "}}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+static std::vector<int> parseSizes(const char* list) {
+    std::vector<int> sizes;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (std::atoi(item.c_str()) > 0) sizes.push_back(std::atoi(item.c_str()));
+    }
+    return sizes;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<int> sizes = parseSizes("256,1024,4096");
+    int seeds = 3;
+    int threads = hardwareThreads();
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--sizes") == 0 && hasValue) sizes = parseSizes(argv[++i]);
+        else if (std::strcmp(argv[i], "--seeds") == 0 && hasValue) seeds = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) threads = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--json") == 0 && hasValue) jsonPath = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--sizes 256,1024,4096] [--seeds 3] [--threads N] [--json results.json]" << std::endl;
+            return 1;
+        }
+    }
+
+    const int kinds[] = {GENERATOR_CELLULAR_AUTOMATA, GENERATOR_PRIM, GENERATOR_L_SYSTEM, GENERATOR_DRUNK_WALK};
+    std::vector<BenchResult> results;
+
+    std::printf("%-10s %6s %6s %10s %10s %9s %8s %9s %6s  %s\n",
+                "generator", "size", "seed", "time(ms)", "Mcells/s", "peakMB", "allocs", "allocMB", "path", "phases");
+    for (int kind : kinds) {
+        for (int size : sizes) {
+            for (int seed = 1; seed <= seeds; ++seed) {
+                results.push_back(runOnce(kind, size, seed, threads));
+                printRow(results.back());
+            }
+        }
+    }
+
+    if (!jsonPath.empty()) {
+        std::ofstream json(jsonPath.c_str());
+        if (!json) {
+            std::cerr << "Failed to write " << jsonPath << std::endl;
+            return 1;
+        }
+        writeJson(json, results, threads);
+    }
+    return 0;
+}
@@ -0,0 +1,189 @@
+// mazefile.cpp
+#include "mazefile.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// Rounds a file offset up to the next 8-byte boundary
+static uint64_t alignOffset(uint64_t offset) {
+    return (offset + 7) & ~uint64_t(7);
+}
+
+// Whether count items of itemSize bytes starting at offset lie inside a file of length bytes.
+// Written so that no term can wrap around, since a corrupt header may hold any values.
+static bool sectionFits(uint64_t offset, uint64_t count, uint64_t itemSize, uint64_t length) {
+    return offset <= length && count <= (length - offset) / itemSize;
+}
+
+bool MappedMazeFile::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(MazeFileHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file alive
+    if (mapping == MAP_FAILED) return false;
+
+    data = static_cast<const uint8_t*>(mapping);
+    length = info.st_size;
+
+    const MazeFileHeader& h = header();
+    bool valid = h.magic == MAZE_FILE_MAGIC && h.version == MAZE_FILE_VERSION &&
+                 h.params.rows >= 0 && h.params.cols >= 0 &&
+                 h.cellsOffset % 8 == 0 && h.lightsOffset % 8 == 0 && h.treesOffset % 8 == 0 &&
+                 sectionFits(h.cellsOffset, static_cast<uint64_t>(h.params.rows) * h.params.cols, 1, length) &&
+                 sectionFits(h.lightsOffset, h.lightCount, sizeof(MazeFileCell), length) &&
+                 sectionFits(h.treesOffset, h.treeCount, sizeof(MazeFileCell), length);
+    if (!valid) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedMazeFile::close() {
+    if (data) munmap(const_cast<uint8_t*>(data), length);
+    data = NULL;
+    length = 0;
+}
+
+bool writeMazeFile(const std::string& path, const MazeParams& params, const Level& level) {
+    if (params.rows != level.grid.rows() || params.cols != level.grid.cols()) return false;
+
+    MazeFileHeader header = MazeFileHeader(); // Value-initialised, so padding bytes are zero too
+    header.magic = MAZE_FILE_MAGIC;
+    header.version = MAZE_FILE_VERSION;
+    header.params = params;
+    header.cellsOffset = alignOffset(sizeof(MazeFileHeader));
+    header.lightsOffset = alignOffset(header.cellsOffset + level.grid.size());
+    header.lightCount = level.lights.size();
+    header.treesOffset = alignOffset(header.lightsOffset + header.lightCount * sizeof(MazeFileCell));
+    header.treeCount = level.trees.size();
+
+    std::vector<MazeFileCell> lights(level.lights.size());
+    for (size_t i = 0; i < lights.size(); ++i) {
+        lights[i].row = level.lights[i].row;
+        lights[i].col = level.lights[i].col;
+    }
+    std::vector<MazeFileCell> trees(level.trees.size());
+    for (size_t i = 0; i < trees.size(); ++i) {
+        trees[i].row = level.trees[i].row;
+        trees[i].col = level.trees[i].col;
+    }
+
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+
+        const char padding[8] = {0};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(padding, header.cellsOffset - sizeof(header));
+        out.write(reinterpret_cast<const char*>(level.grid.data()), level.grid.size());
+        out.write(padding, header.lightsOffset - (header.cellsOffset + level.grid.size()));
+        out.write(reinterpret_cast<const char*>(lights.data()), lights.size() * sizeof(MazeFileCell));
+        out.write(padding, header.treesOffset - (header.lightsOffset + lights.size() * sizeof(MazeFileCell)));
+        out.write(reinterpret_cast<const char*>(trees.data()), trees.size() * sizeof(MazeFileCell));
+        if (!out) {
+            out.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+// Params are compared and hashed byte by byte, so padding bytes (which copies need not keep) must not exist
+static_assert(sizeof(MazeParams) == 12 * sizeof(int32_t) + 2 * sizeof(uint64_t), "MazeParams must not contain padding");
+
+// Lights and trees are handed out as Cells pointing into the mapping, so the two layouts must agree
+static_assert(sizeof(Cell) == sizeof(MazeFileCell) && sizeof(int) == sizeof(int32_t), "Cell must match MazeFileCell");
+
+bool readMazeFile(const std::string& path, const MazeParams& params, LevelView& level) {
+    std::shared_ptr<MappedMazeFile> file(new MappedMazeFile());
+    if (!file->open(path)) return false;
+
+    const MazeFileHeader& header = file->header();
+    if (std::memcmp(&header.params, &params, sizeof(MazeParams)) != 0) return false;
+
+    level = LevelView(file, file->cells(), header.params.rows, header.params.cols,
+                      reinterpret_cast<const Cell*>(file->lights()), header.lightCount,
+                      reinterpret_cast<const Cell*>(file->trees()), header.treeCount);
+    return true;
+}
+
+std::string MazeCache::pathFor(const MazeParams& params) const {
+    // FNV-1a over the parameter bytes and the format version
+    uint64_t hash = 1469598103934665603ULL;
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&params);
+    for (size_t i = 0; i < sizeof(MazeParams); ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    hash = (hash ^ MAZE_FILE_VERSION) * 1099511628211ULL;
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "maze-%016llx.bin", static_cast<unsigned long long>(hash));
+    return directory + "/" + name;
+}
+
+bool MazeCache::load(const MazeParams& params, LevelView& level) const {
+    std::string path = pathFor(params);
+    if (!readMazeFile(path, params, level)) return false;
+    utimes(path.c_str(), NULL); // The modification time orders files for trim()
+    return true;
+}
+
+bool MazeCache::store(const MazeParams& params, const Level& level) {
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) return false;
+    if (!counted) {
+        fileCount = trim();
+        counted = true;
+    }
+    if (!writeMazeFile(pathFor(params), params, level)) return false;
+    if (++fileCount > maxFiles) fileCount = trim();
+    return true;
+}
+
+size_t MazeCache::trim() {
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) return 0;
+
+    // (modification time, path) of every maze file; temporary files are left alone
+    std::vector<std::pair<time_t, std::string>> files;
+    while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.compare(0, 5, "maze-") != 0 || name.size() < 4 || name.compare(name.size() - 4, 4, ".bin") != 0) continue;
+
+        std::string path = directory + "/" + name;
+        struct stat info;
+        if (stat(path.c_str(), &info) == 0) files.push_back(std::make_pair(info.st_mtime, path));
+    }
+    closedir(dir);
+    if (files.size() <= maxFiles) return files.size();
+
+    // Mapped files stay valid after unlinking, so levels still in use are unaffected
+    std::sort(files.begin(), files.end());
+    size_t excess = files.size() - maxFiles * 3 / 4;
+    for (size_t i = 0; i < excess; ++i) {
+        std::remove(files[i].second.c_str());
+    }
+    return files.size() - excess;
+}
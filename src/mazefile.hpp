@@ -0,0 +1,86 @@
+// mazefile.hpp
+#ifndef MAZEFILE_H
+#define MAZEFILE_H
+
+#include <cstdint>
+#include <string>
+
+#include "mazegen.hpp"
+
+#define MAZE_FILE_MAGIC 0x5A4D5343u // "CSMZ" in a little-endian file
+#define MAZE_FILE_VERSION 5 // Bump whenever generation or decoration output changes
+#define MAZE_CACHE_DIR "cache" // Relative to the working directory, like assets/
+#define MAZE_CACHE_FILES 4096 // Files a cache keeps before deleting the least recently used (~85 MB of chunks)
+
+// A light or tree position as stored on disk
+struct MazeFileCell {
+    int32_t row, col;
+};
+
+// File layout: header, then rows * cols cell bytes (row-major, same layout as Grid), then the
+// light list and the tree list. Every section starts on an 8-byte boundary, so a mapped file
+// is used in place without any parsing or copying (see readMazeFile).
+struct MazeFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    MazeParams params;
+    uint64_t cellsOffset;
+    uint64_t lightsOffset;
+    uint64_t lightCount;
+    uint64_t treesOffset;
+    uint64_t treeCount;
+};
+
+// Read-only mmap of a maze file. open() validates the header and section bounds.
+class MappedMazeFile {
+public:
+    MappedMazeFile() : data(NULL), length(0) {}
+    ~MappedMazeFile() { close(); }
+
+    bool open(const std::string& path);
+    void close();
+
+    const MazeFileHeader& header() const { return *reinterpret_cast<const MazeFileHeader*>(data); }
+    const uint8_t* cells() const { return data + header().cellsOffset; }
+    const MazeFileCell* lights() const { return reinterpret_cast<const MazeFileCell*>(data + header().lightsOffset); }
+    const MazeFileCell* trees() const { return reinterpret_cast<const MazeFileCell*>(data + header().treesOffset); }
+
+private:
+    const uint8_t* data;
+    size_t length;
+
+    MappedMazeFile(const MappedMazeFile&);
+    MappedMazeFile& operator=(const MappedMazeFile&);
+};
+
+// Writes level to path (through a temporary file, so readers never see a partial file)
+bool writeMazeFile(const std::string& path, const MazeParams& params, const Level& level);
+
+// Maps a maze file and points level straight into it if its header matches params exactly.
+// Nothing is copied; the view keeps the file mapped for as long as it or a copy of it exists.
+bool readMazeFile(const std::string& path, const MazeParams& params, LevelView& level);
+
+// Directory of maze files named after a hash of their MazeParams. A request with identical
+// parameters maps the stored file instead of generating the level again. Once the directory
+// holds more than maxFiles maze files, the least recently used ones are deleted.
+class MazeCache {
+public:
+    explicit MazeCache(const std::string& directory, size_t maxFiles = MAZE_CACHE_FILES)
+        : directory(directory), maxFiles(maxFiles), fileCount(0), counted(false) {}
+
+    std::string pathFor(const MazeParams& params) const;
+    bool load(const MazeParams& params, LevelView& level) const; // Also marks the file as recently used
+    bool store(const MazeParams& params, const Level& level);
+
+private:
+    std::string directory;
+    size_t maxFiles;
+    size_t fileCount; // Maze files in the directory, counted on the first store
+    bool counted;
+
+    // Deletes the least recently used files down to 3/4 of maxFiles if there are more than
+    // maxFiles, so the directory is only scanned again after many more stores; returns the count
+    size_t trim();
+};
+
+#endif // MAZEFILE_H
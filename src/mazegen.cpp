@@ -1,26 +1,84 @@
 #include "mazegen.hpp"
 
+const char* generatorName(uint32_t kind) {
+    switch (kind) {
+        case GENERATOR_CELLULAR_AUTOMATA: return "cellular";
+        case GENERATOR_PRIM: return "prim";
+        case GENERATOR_DRUNK_WALK: return "drunkwalk";
+        case GENERATOR_L_SYSTEM: return "lsystem";
+        default: return "unknown";
+    }
+}
+
 bool isInBounds(int row, int col, int rows, int cols) {
     return row >= 0 && row < rows && col >= 0 && col < cols;
 }
 
-void CellularAutomataGenerator::generateMaze(std::vector<std::vector<int>>& grid, int rows, int cols) {
-    initializeGrid(grid);
+LevelView::LevelView(const std::shared_ptr<const Level>& level)
+    : owner(level), lightCells(level->lights.data()), lightTotal(level->lights.size()),
+      treeCells(level->trees.data()), treeTotal(level->trees.size()) {
+    // Only ever read through grid(), so viewing the const level's cells is safe
+    cells = Grid::view(const_cast<uint8_t*>(level->grid.data()), level->grid.rows(), level->grid.cols());
+}
+
+LevelView::LevelView(const std::shared_ptr<const void>& owner, const uint8_t* cells, int rows, int cols,
+                     const Cell* lights, size_t lightCount, const Cell* trees, size_t treeCount)
+    : owner(owner), cells(Grid::view(const_cast<uint8_t*>(cells), rows, cols)), lightCells(lights),
+      lightTotal(lightCount), treeCells(trees), treeTotal(treeCount) {}
+
+void CellularAutomataGenerator::generateMaze(Grid& grid) {
+    {
+        ScopedPhase phase(phases, "init");
+        initializeGrid(grid);
+    }
+    if (steps <= 0) return;
 
-    for (int i = 0; i < steps; i++) {
-        grid = applyCARules(grid);
+    // Run the steps on packed PATH bits, ping-ponging between two preallocated planes
+    BitPlane current;
+    BitPlane next(grid.rows(), grid.cols());
+    {
+        ScopedPhase phase(phases, "pack");
+        grid.packBits(PATH, current);
     }
+
+    // Each thread owns a band of rows and reads one halo row on either side from the shared
+    // source plane; the barrier keeps every band on the same step before the planes swap roles
+    BitPlane* planes[2] = {&current, &next};
+    {
+        ScopedPhase phase(phases, "steps");
+        int bands = gridThreads(threads, grid.rows(), grid.cols());
+        Barrier barrier(bands);
+        parallelFor(0, grid.rows(), bands, [&](int rowBegin, int rowEnd, int) {
+            for (int i = 0; i < steps; i++) {
+                applyCARules(*planes[i & 1], *planes[(i + 1) & 1], rowBegin, rowEnd);
+                barrier.wait();
+            }
+        });
+    }
+
+    ScopedPhase phase(phases, "unpack");
+    grid.unpackBits(*planes[steps & 1], PATH, WALL);
+}
+
+void CellularAutomataGenerator::describe(MazeParams& params) const {
+    params.generator = GENERATOR_CELLULAR_AUTOMATA;
+    params.wallProbability = wallProbability;
+    params.steps = steps;
 }
 
-void CellularAutomataGenerator::initializeGrid(std::vector<std::vector<int>>& grid) {
-    int rows = grid.size();
-    int cols = grid[0].size();
+void CellularAutomataGenerator::initializeGrid(Grid& grid) {
+    int cols = grid.cols();
 
-    for (int row = 0; row < rows; ++row) {
-        for (int col = 0; col < cols; ++col) {
-            grid[row][col] = (rand() / static_cast<float>(RAND_MAX)) < wallProbability ? WALL : PATH;
+    // One RNG stream per row, so bands of rows can be filled in parallel with the same result
+    parallelFor(0, grid.rows(), gridThreads(threads, grid.rows(), cols), [&](int rowBegin, int rowEnd, int) {
+        for (int row = rowBegin; row < rowEnd; ++row) {
+            Rng rng = stream(row);
+            uint8_t* cells = grid[row];
+            for (int col = 0; col < cols; ++col) {
+                cells[col] = rng.nextFloat() < wallProbability ? WALL : PATH;
+            }
         }
-    }
+    });
 
     // for (int i = 0; i < rows; ++i) {
     //     grid[i][0] = WALL;
@@ -32,157 +90,271 @@ void CellularAutomataGenerator::initializeGrid(std::vector<std::vector<int>>& gr
     // }
 }
 
-std::vector<std::vector<int>> CellularAutomataGenerator::applyCARules(const std::vector<std::vector<int>> &grid) {
-    std::vector<std::vector<int>> newGrid = grid;
+// Bit-sliced full adder over 64 cells: a + b + c = sum + 2 * carry, per bit
+static inline void fullAdd(uint64_t a, uint64_t b, uint64_t c, uint64_t& sum, uint64_t& carry) {
+    uint64_t partial = a ^ b;
+    sum = partial ^ c;
+    carry = (a & b) | (partial & c);
+}
 
-    int rows = grid.size();
-    int cols = grid[0].size();
+// Word w of a row, or 0 for rows/words outside the grid
+static inline uint64_t loadWord(const uint64_t* row, int word, int words) {
+    return (row && word >= 0 && word < words) ? row[word] : 0;
+}
 
-    for (int row = 0; row < rows; ++row) {
-        for (int col = 0; col < cols; ++col) {
-            int wallNeighbors = countWallNeighbors(grid, row, col);
+// One CA step for rows [rowBegin, rowEnd): a cell becomes PATH (1) when at least 5 of its
+// 8 neighbours are PATH, cells outside the grid count as 0. Rows rowBegin - 1 and rowEnd
+// are only read, so bands of the same step can run independently.
+void CellularAutomataGenerator::applyCARules(const BitPlane& current, BitPlane& next, int rowBegin, int rowEnd) const {
+    int rows = current.rows();
+    int words = current.words();
+    uint64_t lastMask = current.lastWordMask();
 
-            if (wallNeighbors >= 5) newGrid[row][col] = 1;
-            else newGrid[row][col] = 0;
-        }
-    }
-    return newGrid;
-}
+    for (int row = rowBegin; row < rowEnd; ++row) {
+        const uint64_t* above = row > 0 ? current.row(row - 1) : NULL;
+        const uint64_t* middle = current.row(row);
+        const uint64_t* below = row + 1 < rows ? current.row(row + 1) : NULL;
+        uint64_t* out = next.row(row);
 
-int CellularAutomataGenerator::countWallNeighbors(const std::vector<std::vector<int>>& grid, int row, int col) {
-    int wallCount = 0;
-    int rows = grid.size();
-    int cols = grid[0].size();
+        // Rolling window of the previous, current and next word of the three source rows
+        uint64_t abovePrev = 0, aboveCur = loadWord(above, 0, words);
+        uint64_t middlePrev = 0, middleCur = loadWord(middle, 0, words);
+        uint64_t belowPrev = 0, belowCur = loadWord(below, 0, words);
 
-    for (int i = -1; i <= 1; ++i) {
-        for (int j = -1; j <= 1; ++j) {
-            if (i == 0 && j == 0) continue;
-            int newRow = row + i;
-            int newCol = col + j;
-            if (newRow >= 0 && newRow < rows && newCol >= 0 && newCol < cols) {
-                wallCount += grid[newRow][newCol];
-            }
+        for (int word = 0; word < words; ++word) {
+            uint64_t aboveNext = loadWord(above, word + 1, words);
+            uint64_t middleNext = loadWord(middle, word + 1, words);
+            uint64_t belowNext = loadWord(below, word + 1, words);
+
+            // Bit i holds column i, so the west neighbour comes from bit i - 1 and the east one from bit i + 1
+            uint64_t topSum, topCarry, bottomSum, bottomCarry;
+            fullAdd((aboveCur << 1) | (abovePrev >> 63), aboveCur, (aboveCur >> 1) | (aboveNext << 63), topSum, topCarry);
+            fullAdd((belowCur << 1) | (belowPrev >> 63), belowCur, (belowCur >> 1) | (belowNext << 63), bottomSum, bottomCarry);
+            uint64_t west = (middleCur << 1) | (middlePrev >> 63);
+            uint64_t east = (middleCur >> 1) | (middleNext << 63);
+            uint64_t sideSum = west ^ east;
+            uint64_t sideCarry = west & east;
+
+            // count = ones + 2 * twos, with twos = twosLow + 2 * (twosHigh + twosExtra)
+            uint64_t ones, onesCarry, twosParity, twosHigh;
+            fullAdd(topSum, sideSum, bottomSum, ones, onesCarry);
+            fullAdd(topCarry, sideCarry, bottomCarry, twosParity, twosHigh);
+            uint64_t twosLow = twosParity ^ onesCarry;
+            uint64_t twosExtra = twosParity & onesCarry;
+
+            // count >= 5  <=>  twos >= 3, or twos == 2 and ones is set
+            uint64_t result = (twosHigh & twosExtra) | ((twosHigh ^ twosExtra) & (twosLow | ones));
+            if (word == words - 1) result &= lastMask;
+            out[word] = result;
+
+            abovePrev = aboveCur; aboveCur = aboveNext;
+            middlePrev = middleCur; middleCur = middleNext;
+            belowPrev = belowCur; belowCur = belowNext;
         }
     }
-    return wallCount;
 }
 
-void PrimGenerator::generateMaze(std::vector<std::vector<int>>& grid, int rows, int cols){
+// Offsets of the lattice neighbours two cells away (up, down, left, right)
+static const int PRIM_OFFSETS[4][2] = {{-2, 0}, {2, 0}, {0, -2}, {0, 2}};
+
+void PrimGenerator::generateMaze(Grid& grid){
+    ScopedPhase phase(phases, "carve");
+    Rng rng = stream(0);
     std::vector<Cell> frontier;
+    frontier.reserve(static_cast<size_t>(grid.rows() / 2 + 1) * (grid.cols() / 2 + 1) / 4);
+    BitPlane inFrontier(grid.rows(), grid.cols()); // Each wall cell is queued at most once
 
     // Start at a random cell and mark it as a path
     Cell start(1, 1);
     grid[start.row][start.col] = PATH;
-    addFrontier(start, grid, frontier);
+    addFrontier(start, grid, frontier, inFrontier);
 
     // Randomly process frontier cells
     while (!frontier.empty()) {
-        int idx = rand() % frontier.size();
+        int idx = rng.nextInt(frontier.size());
         Cell cell = frontier[idx];
-        frontier.erase(frontier.begin() + idx);
+        frontier[idx] = frontier.back(); // Swap-and-pop: order is irrelevant since picks are random
+        frontier.pop_back();
 
         // Get neighboring path cells
-        std::vector<Cell> neighbors;
-        if (isInBounds(cell.row - 2, cell.col, rows, cols) && grid[cell.row - 2][cell.col] == PATH)
-            neighbors.push_back({cell.row - 2, cell.col});
-        if (isInBounds(cell.row + 2, cell.col, rows, cols) && grid[cell.row + 2][cell.col] == PATH)
-            neighbors.push_back({cell.row + 2, cell.col});
-        if (isInBounds(cell.row, cell.col - 2, rows, cols) && grid[cell.row][cell.col - 2] == PATH)
-            neighbors.push_back({cell.row, cell.col - 2});
-        if (isInBounds(cell.row, cell.col + 2, rows, cols) && grid[cell.row][cell.col + 2] == PATH)
-            neighbors.push_back({cell.row, cell.col + 2});
+        int neighbors[4];
+        int neighborCount = 0;
+        for (int i = 0; i < 4; ++i) {
+            int row = cell.row + PRIM_OFFSETS[i][0];
+            int col = cell.col + PRIM_OFFSETS[i][1];
+            if (grid.inBounds(row, col) && grid[row][col] == PATH) neighbors[neighborCount++] = i;
+        }
 
         // If there is a neighboring path, carve a passage
-        if (!neighbors.empty()) {
-            Cell neighbor = neighbors[rand() % neighbors.size()];
+        if (neighborCount > 0) {
+            const int* offset = PRIM_OFFSETS[neighbors[rng.nextInt(neighborCount)]];
             grid[cell.row][cell.col] = PATH;
-            grid[(cell.row + neighbor.row) / 2][(cell.col + neighbor.col) / 2] = PATH;
-            addFrontier(cell, grid, frontier);
+            grid[cell.row + offset[0] / 2][cell.col + offset[1] / 2] = PATH;
+            addFrontier(cell, grid, frontier, inFrontier);
         }
     }
 }
 
-void PrimGenerator::addFrontier(const Cell& cell, const std::vector<std::vector<int>>& grid, std::vector<Cell>& frontier) {
-    int rows = grid.size();
-    int cols = grid[0].size();
-    std::vector<Cell> neighbors = {
-        {cell.row - 2, cell.col},
-        {cell.row + 2, cell.col},
-        {cell.row, cell.col - 2},
-        {cell.row, cell.col + 2}
-    };
+void PrimGenerator::describe(MazeParams& params) const {
+    params.generator = GENERATOR_PRIM;
+}
 
-    for (const Cell& neighbor : neighbors) {
-        if (neighbor.isInsideGrid(rows, cols) && grid[neighbor.row][neighbor.col] == WALL) {
-            frontier.push_back(neighbor);
+void PrimGenerator::addFrontier(const Cell& cell, const Grid& grid, std::vector<Cell>& frontier, BitPlane& inFrontier) {
+    for (int i = 0; i < 4; ++i) {
+        int row = cell.row + PRIM_OFFSETS[i][0];
+        int col = cell.col + PRIM_OFFSETS[i][1];
+        if (grid.inBounds(row, col) && grid[row][col] == WALL && !inFrontier.test(row, col)) {
+            inFrontier.set(row, col);
+            frontier.push_back(Cell(row, col));
         }
     }
 }
 
-void DrunkWalkGenerator::generateMaze(std::vector<std::vector<int>>& grid, int rows, int cols){
-    int row = rows - 1;
-    int col = 0;
+void DrunkWalkGenerator::generateMaze(Grid& grid){
+    int rows = grid.rows();
+    int cols = grid.cols();
+
+    // All walkers carve into one shared bit plane. Walker i always uses stream i and setting a
+    // bit is order independent, so the maze depends only on the seed and the walker count.
+    BitPlane carved(rows, cols);
+
+    {
+        ScopedPhase phase(phases, "walk");
+        int bands = std::max(1, std::min(threads, walkers));
+        parallelFor(0, walkers, bands, [&](int first, int last, int) {
+            for (int i = first; i < last; i++) {
+                Rng rng = stream(i);
+                int row = rows - 1;
+                int col = 0;
+                if (i > 0) {
+                    row = rng.nextInt(rows);
+                    col = rng.nextInt(cols);
+                }
+                walk(rng, carved, row, col);
+            }
+        });
+    }
+
+    ScopedPhase phase(phases, "merge");
+    grid.orBits(carved, PATH);
+}
+
+void DrunkWalkGenerator::walk(Rng& rng, BitPlane& carved, int row, int col) const {
+    // Up, down, left, right; a step off the grid is clamped back, i.e. the walker stays put
+    static const int dRow[4] = {-1, 1, 0, 0};
+    static const int dCol[4] = {0, 0, -1, 1};
+    int maxRow = carved.rows() - 1;
+    int maxCol = carved.cols() - 1;
 
     for (int i = 0; i < steps; ++i) {
-        grid[row][col] = PATH;
+        // Relaxed atomic OR: other walkers may share the word. The plain load skips the locked
+        // instruction once the cell is carved, which is most steps in a long walk.
+        uint64_t* word = &carved.row(row)[col >> 6];
+        uint64_t bit = uint64_t(1) << (col & 63);
+        if (!(__atomic_load_n(word, __ATOMIC_RELAXED) & bit)) __atomic_fetch_or(word, bit, __ATOMIC_RELAXED);
+
+        int direction = rng.nextInt(4);
+        row = std::min(std::max(row + dRow[direction], 0), maxRow);
+        col = std::min(std::max(col + dCol[direction], 0), maxCol);
+    }
+}
+
+void DrunkWalkGenerator::describe(MazeParams& params) const {
+    params.generator = GENERATOR_DRUNK_WALK;
+    params.steps = steps;
+    params.walkers = walkers;
+}
+
+void LSystemGenerator::generateMaze(Grid& grid){
+    int rows = grid.rows();
+    int cols = grid.cols();
 
-        int direction = rand() % 4;
+    // Walkers carve into one bit plane per band; start point i always uses stream i, and the
+    // planes are OR-ed together, so the maze does not depend on the thread count
+    int bands = std::max(1, std::min(threads, startpoints));
+    std::vector<BitPlane> carved(bands, BitPlane(rows, cols));
 
-        if (direction == 0 && row > 0) row--;           // Up
-        else if (direction == 1 && row < rows - 1) row++; // Down
-        else if (direction == 2 && col > 0) col--;        // Left
-        else if (direction == 3 && col < cols - 1) col++; // Right
+    {
+        ScopedPhase phase(phases, "walk");
+        parallelFor(0, startpoints, bands, [&](int first, int last, int band) {
+            for (int i = first; i < last; i++) {
+                Rng rng = stream(i);
+                int row = rows - 1;
+                int col = 0;
+                if (i > 0) {
+                    // Choose start randomly
+                    row = rng.nextInt(rows);
+                    col = rng.nextInt(cols);
+                }
+                LSystemExpander instructions(axiom, rules, iterations, rng);
+                interpretLSystem(instructions, carved[band], row, col);
+            }
+        });
+    }
+
+    ScopedPhase phase(phases, "merge");
+    for (const BitPlane& plane : carved) {
+        grid.orBits(plane, PATH);
     }
 }
 
-void LSystemGenerator::generateMaze(std::vector<std::vector<int>>& grid, int rows, int cols){
-    for (int i = 0; i < startpoints; i++) {
-        std::string instructions = evolveLSystem();
-        if (i == 0) {
-            interpretLSystem(instructions, grid, rows - 1, 0);
-        } else {
-            // Choose start randomly
-            int row = rand() % rows;
-            int col = rand() % cols;
-            interpretLSystem(instructions, grid, row, col);
-        }
+void LSystemGenerator::describe(MazeParams& params) const {
+    params.generator = GENERATOR_L_SYSTEM;
+    params.iterations = iterations;
+    params.startpoints = startpoints;
+}
+
+LSystemExpander::LSystemExpander(const std::string& axiom, const std::unordered_map<char, std::vector<std::string>>& rules, int iterations, Rng& rng)
+    : iterations(iterations), rng(rng) {
+    std::fill(ruleFor, ruleFor + 256, static_cast<const std::vector<std::string>*>(NULL));
+    for (const auto& rule : rules) {
+        if (!rule.second.empty()) ruleFor[static_cast<unsigned char>(rule.first)] = &rule.second;
     }
+
+    stack.reserve(iterations + 1); // One frame per rewrite level, never reallocates
+    stack.push_back(Frame{&axiom, 0, 0});
 }
 
-std::string LSystemGenerator:: evolveLSystem() const {
-    std::string result = axiom;
-    for (int i = 0; i < iterations; ++i) {
-        std::string next;
-        for (char c : result) {
-            if (rules.find(c) != rules.end()) {
-                const std::vector<std::string>& possibleRules = rules.at(c);
-                next += possibleRules[rand() % possibleRules.size()]; // Randomly select a rule
-            } else {
-                next += c;
-            }
+bool LSystemExpander::next(char& command) {
+    while (!stack.empty()) {
+        Frame& top = stack.back();
+        if (top.pos == top.symbols->size()) {
+            stack.pop_back();
+            continue;
         }
-        result = next;
+
+        char symbol = (*top.symbols)[top.pos++];
+        const std::vector<std::string>* possibleRules = ruleFor[static_cast<unsigned char>(symbol)];
+        if (possibleRules && top.depth < iterations) {
+            int depth = top.depth + 1;
+            stack.push_back(Frame{&(*possibleRules)[rng.nextInt(possibleRules->size())], 0, depth}); // Randomly select a rule
+            continue;
+        }
+
+        command = symbol;
+        return true;
     }
-    return result;
+    return false;
 }
 
-void LSystemGenerator::interpretLSystem(const std::string& instructions, std::vector<std::vector<int>>& grid, int startRow, int startCol) const {
-    int rows = grid.size();
-    int cols = grid[0].size();
+void LSystemGenerator::interpretLSystem(LSystemExpander& instructions, BitPlane& carved, int startRow, int startCol) const {
+    int rows = carved.rows();
+    int cols = carved.cols();
     int direction = 0; // 0=up, 1=right, 2=down, 3=left
     int row = startRow;
     int col = startCol;
 
-    grid[row][col] = PATH;
+    carved.set(row, col);
 
-    for (char command : instructions) {
+    char command;
+    while (instructions.next(command)) {
         if (command == 'F') {
             // Move in the current direction
             if (direction == 0 && row > 0) row--;       // Move up
             else if (direction == 1 && col < cols - 1) col++; // Move right
             else if (direction == 2 && row < rows - 1) row++; // Move down
             else if (direction == 3 && col > 0) col--;       // Move left
-            grid[row][col] = PATH;
+            carved.set(row, col);
         } else if (command == '+') {
             direction = (direction + 1) % 4; // Turn right
         } else if (command == '-') {
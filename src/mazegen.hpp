@@ -1,6 +1,9 @@
+#ifndef MAZEGEN_H
+#define MAZEGEN_H
+
 #include <vector>
-#include <cstdlib> // For rand() and srand()
-#include <ctime>   // For seeding rand()
+#include <cstdlib>
+#include <ctime>   // For the default seed
 #include <iostream>
 #include <stack>
 #include <algorithm> 
@@ -8,11 +11,20 @@
 #include <queue>
 #include <unistd.h>
 #include <cmath>
+#include <cstring>
+#include <string>
+#include <memory>
+
+#include "grid.hpp"
+#include "parallel.hpp"
+#include "profile.hpp"
+#include "rng.hpp"
 
 #define GRID_SPACING 10 // Size of each cell (40x40 pixels)
 #define WALL_PROBABILITY 0.36 // Probability of a cell being a wall
 #define CA_STEPS 5 // Number of Cellular Automata steps
 #define DRUNK_WALK_STEPS 10000 // Number of steps for Drunk Walk generation
+#define DRUNK_WALK_WALKERS 8 // Number of walkers for multi-walker Drunk Walk generation
 #define L_SYSTEM_ITERATIONS 4 // Number of iterations for L-System generation
 #define L_SYSTEM_STARTPOINTS 7 // Number of starting points for L-System generation
 #define WALL 0
@@ -29,37 +41,152 @@ struct Cell {
 
 bool isInBounds(int row, int col, int rows, int cols);
 
+// Everything generation produces: the cell grid plus light and tree cells
+struct Level {
+    Grid grid;
+    std::vector<Cell> lights; // Light sources, including the ones around trees
+    std::vector<Cell> trees;  // Wall cells that a tree grows from
+    long originRow, originCol; // World cell of grid[0][0] when the level is part of a larger world
+
+    Level() : originRow(0), originCol(0) {}
+};
+
+// Read-only level over cells that live elsewhere, in a finished Level or a mapped maze file.
+// owner keeps that storage alive as long as any copy of the view, and copying a view never
+// copies the cells, so handing a mapped level around costs nothing however large it is.
+class LevelView {
+public:
+    LevelView() : lightCells(NULL), lightTotal(0), treeCells(NULL), treeTotal(0) {}
+    // Shares a level that is no longer modified
+    explicit LevelView(const std::shared_ptr<const Level>& level);
+    LevelView(const std::shared_ptr<const void>& owner, const uint8_t* cells, int rows, int cols,
+              const Cell* lights, size_t lightCount, const Cell* trees, size_t treeCount);
+
+    const Grid& grid() const { return cells; } // A view, never an owning grid
+    const Cell* lights() const { return lightCells; }
+    size_t lightCount() const { return lightTotal; }
+    const Cell* trees() const { return treeCells; }
+    size_t treeCount() const { return treeTotal; }
+
+private:
+    std::shared_ptr<const void> owner;
+    Grid cells;
+    const Cell* lightCells;
+    size_t lightTotal;
+    const Cell* treeCells;
+    size_t treeTotal;
+};
+
+enum GeneratorKind {
+    GENERATOR_CELLULAR_AUTOMATA = 1,
+    GENERATOR_PRIM = 2,
+    GENERATOR_DRUNK_WALK = 3,
+    GENERATOR_L_SYSTEM = 4
+};
+
+// Short lowercase name of a GeneratorKind, e.g. "cellular"
+const char* generatorName(uint32_t kind);
+
+// Identifies how a level was generated. Stored in maze file headers and used as the cache key,
+// so it only holds fixed-size fields and is compared bytewise. Thread counts are not part of it
+// since they never change the output.
+struct MazeParams {
+    uint32_t generator;     // GeneratorKind
+    int32_t steps;          // CA steps or drunk walk steps
+    float wallProbability;  // CA only
+    int32_t iterations;     // L-system only
+    int32_t startpoints;    // L-system only
+    int32_t walkers;        // Drunk walk only
+    int32_t reserved;       // Zero; keeps the 64-bit fields below free of padding bytes
+    int32_t chunkSize;      // Chunk size of the world the level belongs to
+    int32_t chunkX, chunkY; // Chunk coordinate, for a level that is one chunk of a world
+    int32_t rows, cols;
+    uint64_t seed;
+    uint64_t passes;        // Hash of the generation pipeline's passes and their parameters
+
+    MazeParams() { std::memset(this, 0, sizeof(*this)); }
+};
+
 class MazeGenerator {
 public:
-    virtual void generateMaze(std::vector<std::vector<int>>& grid, int rows, int cols) = 0;
+    MazeGenerator() : seed(0), phases(NULL) {}
+    virtual ~MazeGenerator() {}
+
+    // All randomness is drawn from this seed, so the same seed gives the same maze
+    // regardless of how many threads a generator uses
+    void setSeed(uint64_t seed) { this->seed = seed; }
+    uint64_t getSeed() const { return seed; }
+
+    // When set, generateMaze adds the wall time of each of its phases to times
+    void setPhaseTimes(PhaseTimes* times) { phases = times; }
+
+    virtual void generateMaze(Grid& grid) = 0;
+    // Fills in the generator kind and its parameters
+    virtual void describe(MazeParams& params) const = 0;
+
+protected:
+    uint64_t seed;
+    PhaseTimes* phases;
+
+    // Independent RNG stream for one row, tile or walker
+    Rng stream(uint64_t id) const { return Rng(seed, id); }
 };
 
 class CellularAutomataGenerator : public MazeGenerator {
 public:
-    CellularAutomataGenerator(float wallProbability, int steps) : wallProbability(wallProbability), steps(steps) {}
+    // threads > 1 runs each step as row bands on that many threads, with identical output
+    CellularAutomataGenerator(float wallProbability, int steps, int threads = 1)
+        : wallProbability(wallProbability), steps(steps), threads(threads) {}
 
-    void generateMaze(std::vector<std::vector<int>>& grid, int rows, int cols) override;
+    void generateMaze(Grid& grid) override;
+    void describe(MazeParams& params) const override;
 
 private:
     float wallProbability;
     int steps;
+    int threads;
 
-    int countWallNeighbors(const std::vector<std::vector<int>>& grid, int row, int col);
-    std::vector<std::vector<int>> applyCARules(const std::vector<std::vector<int>>& grid);
-    void initializeGrid(std::vector<std::vector<int>>& grid);
+    void applyCARules(const BitPlane& current, BitPlane& next, int rowBegin, int rowEnd) const;
+    void initializeGrid(Grid& grid);
 };
 
 class PrimGenerator : public MazeGenerator {
 public:
-    void generateMaze(std::vector<std::vector<int>>& grid, int rows, int cols) override;
+    void generateMaze(Grid& grid) override;
+    void describe(MazeParams& params) const override;
 
 private:
-    void addFrontier(const Cell& cell, const std::vector<std::vector<int>>& grid, std::vector<Cell>& frontier);
+    void addFrontier(const Cell& cell, const Grid& grid, std::vector<Cell>& frontier, BitPlane& inFrontier);
+};
+
+// Expands an L-system depth first and yields one turtle command at a time. Only the current
+// path through the rewrite tree is kept, so memory is O(iterations) instead of O(9^iterations).
+// The axiom, rules and rng are referenced, not copied, and must outlive the expander.
+class LSystemExpander {
+public:
+    LSystemExpander(const std::string& axiom, const std::unordered_map<char, std::vector<std::string>>& rules, int iterations, Rng& rng);
+
+    // Writes the next command and returns true, or returns false once the expansion is exhausted
+    bool next(char& command);
+
+private:
+    struct Frame {
+        const std::string* symbols;
+        size_t pos;
+        int depth;
+    };
+
+    const std::vector<std::string>* ruleFor[256]; // Rewrite options per symbol, NULL if none
+    std::vector<Frame> stack;
+    int iterations;
+    Rng& rng;
 };
 
 class LSystemGenerator : public MazeGenerator {
 public:
-    LSystemGenerator(int iterations, int startpoints) : iterations(iterations), startpoints(startpoints) {
+    // Each start point walks with its own RNG stream; threads > 1 runs the walkers concurrently
+    LSystemGenerator(int iterations, int startpoints, int threads = 1)
+        : iterations(iterations), startpoints(startpoints), threads(threads) {
         rules['F'] = {"F+F-F-F+F", "F-F+F+F-F", "F-F-F+F+F"}; // Multiple rules for randomness
         // rules['+'] = {"+", "-"}; // Turn right or left
         // rules['-'] = {"-", "+"}; // Turn left or right
@@ -68,25 +195,35 @@ public:
         axiom = "F";
     }
 
-    void generateMaze(std::vector<std::vector<int>>& grid, int rows, int cols) override;
+    void generateMaze(Grid& grid) override;
+    void describe(MazeParams& params) const override;
 
 private:
     int iterations;
     int startpoints;
+    int threads;
     std::unordered_map<char, std::vector<std::string>> rules;
     std::string axiom;
 
-    std::string evolveLSystem() const;
-    void interpretLSystem(const std::string& instructions, std::vector<std::vector<int>>& grid, int startRow, int startCol) const;
+    void interpretLSystem(LSystemExpander& instructions, BitPlane& carved, int startRow, int startCol) const;
 };
 
 class DrunkWalkGenerator : public MazeGenerator {
 public:
-    DrunkWalkGenerator(int steps) : steps(steps) {}
+    // Every walker takes `steps` steps with its own RNG stream; the first starts in the
+    // bottom-left corner, the others at random cells. threads > 1 runs the walkers concurrently.
+    DrunkWalkGenerator(int steps, int walkers = 1, int threads = 1)
+        : steps(steps), walkers(walkers), threads(threads) {}
 
-    void generateMaze(std::vector<std::vector<int>>& grid, int rows, int cols) override;
+    void generateMaze(Grid& grid) override;
+    void describe(MazeParams& params) const override;
 
 private:
     int steps;
+    int walkers;
+    int threads;
+
+    void walk(Rng& rng, BitPlane& carved, int row, int col) const;
 };
 
+#endif // MAZEGEN_H
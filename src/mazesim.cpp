@@ -0,0 +1,82 @@
+// mazesim.cpp
+// Headless simulation driver: creates the world, then steps the simulation with scripted random input
+// as fast as possible, for soak tests and profiling on machines without a display. Reports ticks
+// per second and a checksum of the player's path, which is identical for identical arguments.
+//
+//   mazesim [--seed 1] [--rows 320] [--cols 320] [--ticks 100000] [--dt 0.016] [--hold 30]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "sim.hpp"
+
+int main(int argc, char* argv[]) {
+    uint64_t seed = 1;
+    int rows = 320;
+    int cols = 320;
+    long ticks = 100000;
+    float dt = 0.016f;
+    int hold = 30; // Ticks each scripted input is held for
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--seed") == 0 && hasValue) seed = std::strtoull(argv[++i], NULL, 10);
+        else if (std::strcmp(argv[i], "--rows") == 0 && hasValue) rows = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--cols") == 0 && hasValue) cols = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--ticks") == 0 && hasValue) ticks = std::atol(argv[++i]);
+        else if (std::strcmp(argv[i], "--dt") == 0 && hasValue) dt = static_cast<float>(std::atof(argv[++i]));
+        else if (std::strcmp(argv[i], "--hold") == 0 && hasValue) hold = std::atoi(argv[++i]);
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--seed 1] [--rows 320] [--cols 320] [--ticks 100000] [--dt 0.016] [--hold 30]" << std::endl;
+            return 1;
+        }
+    }
+    if (rows <= 0 || cols <= 0 || ticks < 0 || dt <= 0 || hold <= 0) {
+        std::cerr << "Sizes, dt and hold must be positive" << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<ChunkWorld> world = createWorld(seed);
+    Simulation sim(*world, rows, cols, hardwareThreads());
+
+    // The input script has its own stream, so it does not depend on how the level was made
+    Rng script(seed, 1);
+    SimInput input;
+    uint64_t checksum = 1469598103934665603ull;
+    long fallingTicks = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (long tick = 0; tick < ticks; ++tick) {
+        if (tick % hold == 0) {
+            input.up = script.nextInt(4) == 0;
+            input.down = script.nextInt(4) == 0;
+            input.left = script.nextInt(3) == 0;
+            input.right = script.nextInt(3) == 0;
+        }
+        sim.step(input, dt);
+
+        const RenderFrame& frame = sim.frame();
+        if (frame.player.x < 0 || frame.player.y < 0 ||
+            frame.player.x >= cols * GRID_SPACING || frame.player.y >= rows * GRID_SPACING) {
+            std::cerr << "Tick " << tick << ": player left the map at " << frame.player.x << ", " << frame.player.y << std::endl;
+            return 1;
+        }
+        fallingTicks += frame.falling;
+
+        // FNV-1a over the cell the player is in
+        uint32_t cell = static_cast<uint32_t>(frame.player.y / GRID_SPACING) * cols + static_cast<uint32_t>(frame.player.x / GRID_SPACING);
+        checksum = (checksum ^ cell) * 1099511628211ull;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const RenderFrame& frame = sim.frame();
+    std::printf("ticks %ld in %.3f s (%.0f ticks/s), falling %.1f%%, player at %.1f, %.1f, windows %u, checksum %016llx\n",
+                ticks, seconds, seconds > 0 ? ticks / seconds : 0.0, ticks ? 100.0 * fallingTicks / ticks : 0.0,
+                frame.player.x, frame.player.y, frame.windowVersion, static_cast<unsigned long long>(checksum));
+    std::fflush(stdout);
+    world->printStats(std::cout);
+    return 0;
+}
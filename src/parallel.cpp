@@ -0,0 +1,51 @@
+// parallel.cpp
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+int hardwareThreads() {
+    return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+int gridThreads(int threads, int rows, int cols) {
+    long long byWork = static_cast<long long>(rows) * cols / PARALLEL_MIN_CELLS;
+    return static_cast<int>(std::max(1LL, std::min<long long>(std::min(threads, rows), byWork)));
+}
+
+int bandBegin(int begin, int end, int bands, int band) {
+    return begin + static_cast<int>(static_cast<long long>(end - begin) * band / bands);
+}
+
+void parallelFor(int begin, int end, int threads, const std::function<void(int, int, int)>& body) {
+    int bands = std::min(threads, end - begin);
+    if (bands <= 1) {
+        if (begin < end) body(begin, end, 0);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(bands - 1);
+    for (int band = 1; band < bands; ++band) {
+        workers.emplace_back(body, bandBegin(begin, end, bands, band), bandBegin(begin, end, bands, band + 1), band);
+    }
+    body(bandBegin(begin, end, bands, 0), bandBegin(begin, end, bands, 1), 0);
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void Barrier::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    unsigned arrivedIn = generation;
+
+    if (++waiting == count) {
+        waiting = 0;
+        ++generation;
+        released.notify_all();
+        return;
+    }
+    released.wait(lock, [&] { return generation != arrivedIn; });
+}
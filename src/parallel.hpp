@@ -0,0 +1,41 @@
+// parallel.hpp
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+#define PARALLEL_MIN_CELLS 32768 // Fewest grid cells worth starting a thread for
+
+// Number of worker threads to use by default (at least 1)
+int hardwareThreads();
+
+// Threads worth using for a sweep over a rows x cols grid: at most `threads` and one per
+// PARALLEL_MIN_CELLS cells, so small grids such as world chunks run on the calling thread alone
+int gridThreads(int threads, int rows, int cols);
+
+// First index of band `band` when [begin, end) is split into `bands` near-equal bands
+int bandBegin(int begin, int end, int bands, int band);
+
+// Splits [begin, end) into min(threads, end - begin) contiguous bands and runs
+// body(bandBegin, bandEnd, band) for each on its own thread; the calling thread takes band 0.
+// Returns once every band has finished.
+void parallelFor(int begin, int end, int threads, const std::function<void(int, int, int)>& body);
+
+// Reusable barrier: wait() blocks until `count` threads have reached it
+class Barrier {
+public:
+    explicit Barrier(int count) : count(count), waiting(0), generation(0) {}
+
+    void wait();
+
+private:
+    std::mutex mutex;
+    std::condition_variable released;
+    int count;
+    int waiting;
+    unsigned generation;
+};
+
+#endif // PARALLEL_H
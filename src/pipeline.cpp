@@ -0,0 +1,211 @@
+// pipeline.cpp
+#include "pipeline.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+std::string GeneratorPass::name() const {
+    MazeParams params;
+    generator->describe(params);
+    return generatorName(params.generator);
+}
+
+void GeneratorPass::apply(Level& level, Rng& rng, PhaseTimes* phases) {
+    generator->setSeed(rng.next());
+    generator->setPhaseTimes(phases);
+    generator->generateMaze(level.grid);
+    generator->setPhaseTimes(NULL);
+}
+
+// Stream of the border that starts at world cell `start` along seam line `line`
+static uint64_t seamKey(bool vertical, long line, long start) {
+    return ((static_cast<uint64_t>(static_cast<uint32_t>(line)) << 32) | static_cast<uint32_t>(start)) ^
+           (vertical ? 0x5EA3000000000000ULL : 0);
+}
+
+void SeamDoorPass::apply(Level& level, Rng&, PhaseTimes*) {
+    Grid& grid = level.grid;
+    int rows = grid.rows();
+    int cols = grid.cols();
+
+    // Door positions along a border of `length` cells, clear of the corners
+    int doorPositions[SEAM_DOORS];
+    auto pickDoors = [&](bool vertical, long line, long start, int length) {
+        Rng doors(seed, seamKey(vertical, line, start));
+        int range = std::max(length - 2 * SEAM_DOOR_WIDTH, 1);
+        for (int i = 0; i < SEAM_DOORS; ++i) {
+            doorPositions[i] = SEAM_DOOR_WIDTH + static_cast<int>(doors.nextInt(range));
+        }
+    };
+
+    // Left and right borders lie on vertical seams, top and bottom on horizontal ones
+    pickDoors(true, level.originCol, level.originRow, rows);
+    for (int door : doorPositions) {
+        for (int i = 0; i < SEAM_DOOR_WIDTH && door + i < rows; ++i) dig(grid, door + i, 0, 0, 1);
+    }
+    pickDoors(true, level.originCol + cols, level.originRow, rows);
+    for (int door : doorPositions) {
+        for (int i = 0; i < SEAM_DOOR_WIDTH && door + i < rows; ++i) dig(grid, door + i, cols - 1, 0, -1);
+    }
+    pickDoors(false, level.originRow, level.originCol, cols);
+    for (int door : doorPositions) {
+        for (int i = 0; i < SEAM_DOOR_WIDTH && door + i < cols; ++i) dig(grid, 0, door + i, 1, 0);
+    }
+    pickDoors(false, level.originRow + rows, level.originCol, cols);
+    for (int door : doorPositions) {
+        for (int i = 0; i < SEAM_DOOR_WIDTH && door + i < cols; ++i) dig(grid, rows - 1, door + i, -1, 0);
+    }
+}
+
+void SeamDoorPass::dig(Grid& grid, int row, int col, int dRow, int dCol) {
+    // The border cell always opens, so the two halves of a door meet; the corridor then runs at
+    // most halfway into the chunk
+    int depth = std::max(grid.rows(), grid.cols()) / 2;
+    for (int step = 0; step < depth && grid.inBounds(row, col); ++step, row += dRow, col += dCol) {
+        if (step > 0 && grid[row][col] == PATH) return;
+        grid[row][col] = PATH;
+    }
+}
+
+void DecorationPass::apply(Level& level, Rng& rng, PhaseTimes* phases) {
+    Grid& grid = level.grid;
+    int rows = grid.rows();
+    int cols = grid.cols();
+    int bands = gridThreads(threads, rows, cols);
+    uint64_t seed = rng.next();
+
+    std::vector<std::vector<Cell>> bandLights(bands);
+    std::vector<std::vector<Cell>> bandTrees(bands);
+
+    // The sweep only reads the grid. The tree stencil reads the two rows above, which may belong to
+    // another band, so new lights are written in the merge, and a light that is not yet written
+    // still reads as a wall here.
+    const Grid& cells = grid;
+    {
+        ScopedPhase phase(phases, "sweep");
+        parallelFor(0, rows, bands, [&](int rowBegin, int rowEnd, int band) {
+            std::vector<Cell>& lights = bandLights[band];
+            std::vector<Cell>& trees = bandTrees[band];
+            lights.reserve(static_cast<size_t>(rowEnd - rowBegin) * cols / LIGHT_CHANCE * 2);
+
+            for (int row = rowBegin; row < rowEnd; ++row) {
+                Rng rowRng(seed, row);
+                const uint8_t* rowCells = cells[row];
+                bool stencilRow = row >= 2; // The tree stencil reads two rows up and one column either side
+
+                for (int col = 0; col < cols; ++col) {
+                    uint8_t cell = rowCells[col];
+                    if (cell == WALL && rowRng.nextInt(LIGHT_CHANCE) == 0) cell = LIGHT;
+                    if (cell == LIGHT) {
+                        lights.push_back(Cell(row, col));
+                        continue;
+                    }
+                    if (cell != WALL || !stencilRow || col == 0 || col == cols - 1) continue;
+
+                    GridCursor stencil = cells.cursor(row, col);
+                    bool validPosition =
+                        stencil.at(-1, 0) == PATH &&
+                        stencil.at(-1, -1) == PATH &&
+                        stencil.at(-1, 1) == PATH &&
+                        stencil.at(-2, 0) == PATH &&
+                        stencil.at(-2, -1) == PATH &&
+                        stencil.at(-2, 1) == PATH;
+
+                    if (validPosition && rowRng.nextInt(TREE_CHANCE) == 0) { // Randomly decide whether to add the tree
+                        trees.push_back(Cell(row, col));
+                    }
+                }
+            }
+        });
+    }
+
+    // Concatenate in band order: grid lights in row-major order, then five lights per tree
+    ScopedPhase phase(phases, "merge");
+    size_t lightCount = 0;
+    size_t treeCount = 0;
+    for (int band = 0; band < bands; ++band) {
+        lightCount += bandLights[band].size();
+        treeCount += bandTrees[band].size();
+    }
+    level.lights.reserve(level.lights.size() + lightCount + treeCount * 5);
+    level.trees.reserve(level.trees.size() + treeCount);
+
+    for (int band = 0; band < bands; ++band) {
+        for (const Cell& light : bandLights[band]) grid[light.row][light.col] = LIGHT;
+        level.lights.insert(level.lights.end(), bandLights[band].begin(), bandLights[band].end());
+        level.trees.insert(level.trees.end(), bandTrees[band].begin(), bandTrees[band].end());
+    }
+    for (size_t i = level.trees.size() - treeCount; i < level.trees.size(); ++i) {
+        const Cell& tree = level.trees[i];
+        level.lights.push_back(Cell(tree.row, tree.col - 1));
+        level.lights.push_back(Cell(tree.row, tree.col + 1));
+        level.lights.push_back(Cell(tree.row - 1, tree.col));
+        level.lights.push_back(Cell(tree.row - 1, tree.col - 1));
+        level.lights.push_back(Cell(tree.row - 1, tree.col + 1));
+    }
+}
+
+static size_t levelBytes(const Level& level) {
+    return level.grid.size() + (level.lights.capacity() + level.trees.capacity()) * sizeof(Cell);
+}
+
+void GenerationPipeline::run(Level& level, int rows, int cols, Rng& rng) {
+    level.grid.resize(rows, cols, WALL);
+    level.lights.clear();
+    level.trees.clear();
+
+    passStats.clear();
+    for (const auto& pass : passes) {
+        PassStats stats;
+        stats.name = pass->name();
+
+        if (sampleRss) resetPeakRss();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        pass->apply(level, rng, &stats.phases);
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stats.peakRssKb = sampleRss ? peakRssKb() : -1;
+        stats.levelBytes = levelBytes(level);
+
+        passStats.push_back(stats);
+    }
+}
+
+void GenerationPipeline::describe(MazeParams& params) const {
+    // FNV-1a over each pass's name and parameter bytes
+    uint64_t hash = 1469598103934665603ULL;
+    for (const auto& pass : passes) {
+        MazeParams passParams;
+        pass->describe(passParams);
+        if (params.generator == 0) pass->describe(params);
+
+        std::string name = pass->name();
+        for (size_t i = 0; i <= name.size(); ++i) { // Includes the terminator to separate names
+            hash = (hash ^ static_cast<uint8_t>(name.c_str()[i])) * 1099511628211ULL;
+        }
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&passParams);
+        for (size_t i = 0; i < sizeof(MazeParams); ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+    }
+    params.passes = hash;
+}
+
+void printPassStats(std::ostream& out, const std::vector<PassStats>& passStats) {
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-16s %10s %9s %9s  %s\n", "pass", "time(ms)", "peakMB", "levelMB", "phases");
+    out << line;
+    for (const PassStats& stats : passStats) {
+        std::string phases;
+        for (const auto& phase : stats.phases.entries()) {
+            char entry[64];
+            std::snprintf(entry, sizeof(entry), "%s=%.2fms ", phase.first.c_str(), phase.second * 1000.0);
+            phases += entry;
+        }
+        char peak[16] = "-";
+        if (stats.peakRssKb >= 0) std::snprintf(peak, sizeof(peak), "%.1f", stats.peakRssKb / 1024.0);
+        std::snprintf(line, sizeof(line), "%-16s %10.2f %9s %9.2f  %s\n", stats.name.c_str(),
+                      stats.seconds * 1000.0, peak, stats.levelBytes / (1024.0 * 1024.0), phases.c_str());
+        out << line;
+    }
+}
@@ -0,0 +1,118 @@
+// pipeline.hpp
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "mazegen.hpp"
+
+#define LIGHT_CHANCE 80 // One in LIGHT_CHANCE walls becomes a light
+#define TREE_CHANCE 5 // One in TREE_CHANCE valid tree positions gets a tree
+#define SEAM_DOORS 3 // Doors through each chunk border
+#define SEAM_DOOR_WIDTH 2 // Cells per door
+
+// One stage of level generation. Passes edit the level in place, so chaining them never copies
+// the grid. Randomness comes from the rng shared by the whole pipeline, in pass order.
+class GenerationPass {
+public:
+    virtual ~GenerationPass() {}
+
+    virtual std::string name() const = 0;
+    // phases may be NULL; passes that time sub-phases add them there
+    virtual void apply(Level& level, Rng& rng, PhaseTimes* phases) = 0;
+    // Fills in the parameters that change this pass's output (nothing by default)
+    virtual void describe(MazeParams&) const {}
+};
+
+// Runs a generator directly on the level grid. Carving generators (Prim, drunk walk, L-system)
+// only ever set PATH cells, so after another generator they overlay their passages on its maze.
+class GeneratorPass : public GenerationPass {
+public:
+    explicit GeneratorPass(MazeGenerator* generator) : generator(generator) {} // Takes ownership
+
+    std::string name() const override;
+    void apply(Level& level, Rng& rng, PhaseTimes* phases) override;
+    void describe(MazeParams& params) const override { generator->describe(params); }
+
+private:
+    std::unique_ptr<MazeGenerator> generator;
+};
+
+// Carves doors through the borders of a chunk, so caves connect across chunk seams. Each border
+// gets SEAM_DOORS doors, SEAM_DOOR_WIDTH cells wide, at positions drawn from the seed and the
+// border's place in the world alone, so the two chunks sharing a border pick the same doors. Each
+// chunk then digs its side of a door inward until it reaches a cell its generator left open.
+// Runs between the generator and decoration, on levels whose origin is set by the world.
+class SeamDoorPass : public GenerationPass {
+public:
+    explicit SeamDoorPass(uint64_t seed) : seed(seed) {}
+
+    std::string name() const override { return "seams"; }
+    void apply(Level& level, Rng& rng, PhaseTimes* phases) override;
+
+private:
+    uint64_t seed;
+
+    // Digs from border cell (row, col) in direction (dRow, dCol) up to an open cell
+    static void dig(Grid& grid, int row, int col, int dRow, int dCol);
+};
+
+// Decorates the maze in one sweep over the grid: turns random walls into lights, records every
+// LIGHT cell, and places trees on walls with two rows of open cells above them, each lit by five
+// lights. Row bands run on `threads` threads into their own buffers and every row draws from its
+// own RNG stream, so the result does not depend on the thread count.
+class DecorationPass : public GenerationPass {
+public:
+    explicit DecorationPass(int threads = 1) : threads(threads) {}
+
+    std::string name() const override { return "decorate"; }
+    void apply(Level& level, Rng& rng, PhaseTimes* phases) override;
+
+private:
+    int threads;
+};
+
+// What one pass cost when the pipeline last ran
+struct PassStats {
+    std::string name;
+    double seconds;
+    long peakRssKb;    // Peak resident set while the pass ran, or -1 unless the pipeline samples it
+    size_t levelBytes; // Grid, light and tree storage held by the level after the pass
+    PhaseTimes phases; // Sub-phases reported by the pass, if any
+};
+
+// Prints one line per pass with its time, peak resident set, level size and phases
+void printPassStats(std::ostream& out, const std::vector<PassStats>& stats);
+
+// Ordered list of passes run over one level buffer, e.g. a cellular automata world, then an
+// L-system overlay, then decoration
+class GenerationPipeline {
+public:
+    GenerationPipeline() : sampleRss(false) {}
+
+    void add(GenerationPass* pass) { passes.push_back(std::unique_ptr<GenerationPass>(pass)); } // Takes ownership
+
+    // Resets level to a rows x cols wall grid and applies every pass in order
+    void run(Level& level, int rows, int cols, Rng& rng);
+
+    // The first pass that sets a generator fills in the readable fields; params.passes hashes
+    // the name and parameters of every pass, so a different pipeline never hits the same cache entry
+    void describe(MazeParams& params) const;
+
+    // Measures each pass's peak resident set. This resets the process-wide peak-RSS watermark
+    // before every pass, so only turn it on where nothing else measures the process.
+    void setSampleRss(bool sample) { sampleRss = sample; }
+
+    const std::vector<PassStats>& stats() const { return passStats; }
+    void printStats(std::ostream& out) const { printPassStats(out, passStats); }
+
+private:
+    std::vector<std::unique_ptr<GenerationPass>> passes;
+    std::vector<PassStats> passStats;
+    bool sampleRss;
+};
+
+#endif // PIPELINE_H
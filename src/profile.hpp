@@ -0,0 +1,80 @@
+// profile.hpp
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <sys/resource.h>
+#include <utility>
+#include <vector>
+
+// Wall time per named phase, in the order the phases first ran. Repeated phases accumulate.
+class PhaseTimes {
+public:
+    void add(const std::string& phase, double seconds) {
+        for (auto& entry : phases) {
+            if (entry.first == phase) {
+                entry.second += seconds;
+                return;
+            }
+        }
+        phases.push_back(std::make_pair(phase, seconds));
+    }
+
+    double total() const {
+        double seconds = 0.0;
+        for (const auto& entry : phases) seconds += entry.second;
+        return seconds;
+    }
+
+    const std::vector<std::pair<std::string, double>>& entries() const { return phases; }
+    void clear() { phases.clear(); }
+    void reserve(size_t count) { phases.reserve(count); }
+
+private:
+    std::vector<std::pair<std::string, double>> phases;
+};
+
+// Adds the lifetime of the scope to `phase`; does nothing when times is NULL
+class ScopedPhase {
+public:
+    ScopedPhase(PhaseTimes* times, const char* phase) : times(times), phase(phase) {
+        if (times) start = std::chrono::steady_clock::now();
+    }
+    ~ScopedPhase() {
+        if (times) times->add(phase, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+private:
+    PhaseTimes* times;
+    const char* phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Resets the kernel's peak-RSS watermark where supported (Linux), so the next peakRssKb()
+// reports the peak since this call
+inline void resetPeakRss() {
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    if (clearRefs) clearRefs << "5";
+}
+
+inline long peakRssKb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) return std::atol(line.c_str() + 6);
+    }
+
+    // No procfs: fall back to the process-wide peak (bytes on macOS, kilobytes elsewhere)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+#endif // PROFILE_H
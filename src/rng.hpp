@@ -0,0 +1,56 @@
+// rng.hpp
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+// xoshiro256** generator seeded through splitmix64. Every (seed, stream) pair gives an
+// independent sequence, so parallel workers can each draw from their own stream.
+class Rng {
+public:
+    explicit Rng(uint64_t seed = 0, uint64_t stream = 0) {
+        uint64_t x = mix(seed ^ mix(stream + 0x9E3779B97F4A7C15ULL));
+        for (int i = 0; i < 4; ++i) {
+            x += 0x9E3779B97F4A7C15ULL;
+            state[i] = mix(x);
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    // Uniform integer in [0, bound), using the high bits via a multiply instead of a modulo
+    uint32_t nextInt(uint32_t bound) {
+        return static_cast<uint32_t>(((next() >> 32) * bound) >> 32);
+    }
+
+    // Uniform float in [0, 1)
+    float nextFloat() {
+        return (next() >> 40) * (1.0f / 16777216.0f);
+    }
+
+private:
+    uint64_t state[4];
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    // splitmix64 finalizer
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
+#endif // RNG_H
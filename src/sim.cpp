@@ -0,0 +1,271 @@
+// sim.cpp
+#include "sim.hpp"
+
+#include "mazefile.hpp"
+
+#include <chrono>
+
+std::unique_ptr<ChunkWorld> createWorld(uint64_t seed) {
+    // Every chunk is built by a pipeline of passes over one grid, seeded from (seed, chunk coordinate)
+    GenerationPipeline* pipeline = new GenerationPipeline();
+
+    // ------------------------------------ Cellular Automata Maze Generation ------------------------------------
+    pipeline->add(new GeneratorPass(new CellularAutomataGenerator(WALL_PROBABILITY, CA_STEPS, hardwareThreads())));
+
+    // ------------------------------------ Drunk Walk Maze Generation ------------------------------------
+    // pipeline->add(new GeneratorPass(new DrunkWalkGenerator(DRUNK_WALK_STEPS, DRUNK_WALK_WALKERS, hardwareThreads())));
+
+    // ------------------------------------ Prim's Maze Generation ------------------------------------
+    // pipeline->add(new GeneratorPass(new PrimGenerator()));
+
+    // ------------------------------------ L-System Maze Generation ------------------------------------
+    // pipeline->add(new GeneratorPass(new LSystemGenerator(L_SYSTEM_ITERATIONS, L_SYSTEM_STARTPOINTS, hardwareThreads())));
+
+    // ------------------------------------ L-System Overlay ------------------------------------
+    // Carves L-system corridors through whichever maze was generated above
+    // pipeline->add(new GeneratorPass(new LSystemGenerator(L_SYSTEM_ITERATIONS, L_SYSTEM_STARTPOINTS, hardwareThreads())));
+
+    // Opens doors through the chunk borders, so caves carry on into the neighbouring chunks
+    pipeline->add(new SeamDoorPass(seed));
+
+    pipeline->add(new DecorationPass(hardwareThreads()));
+
+    // A chunk made before is mapped from the maze cache instead of being generated again
+    return std::unique_ptr<ChunkWorld>(new ChunkWorld(pipeline, seed, MAZE_CACHE_DIR));
+}
+
+Simulation::Simulation(ChunkWorld& world, int rows, int cols, int threads)
+    : chunks(world), mapRows(rows), mapCols(cols), isMoving(false), moveElapsed(0.0f), fallingSpeed(0.0f),
+      isFalling(false), time(0.0f) {
+    // Spawns the player on the open cell closest to the bottom-left corner that lies in the largest
+    // cave of the window there, so the whole cave is reachable from the start
+    int cornerRow = rows - 1;
+    int cornerCol = 0;
+    playerChunkX = chunks.chunkOf(cornerCol);
+    playerChunkY = chunks.chunkOf(cornerRow);
+    int size = chunks.chunkSize();
+    chunks.prefetch(playerChunkX, playerChunkY, PREFETCH_RADIUS, (cols + size - 1) / size, (rows + size - 1) / size);
+    std::unique_ptr<Window> first = buildWindow(playerChunkX, playerChunkY, cornerRow, cornerCol);
+
+    const Grid& grid = first->level.grid;
+    caves.build(grid, threads);
+    caves.buildDistanceField(grid, caves.nearestInLargest(cornerRow - first->originRow, cornerCol - first->originCol));
+    const Cell& spawn = caves.spawn();
+    position = Vec2((first->originCol + spawn.col) * GRID_SPACING, (first->originRow + spawn.row) * GRID_SPACING);
+
+    renderFrame.windowVersion = 0;
+    install(std::move(first));
+    stream(); // The spawn may lie in a neighbouring chunk
+
+    renderFrame.player = position;
+    renderFrame.falling = false;
+    renderFrame.time = 0.0f;
+}
+
+void Simulation::step(const SimInput& input, float dt) {
+    window->shadeMap->clearDirty();
+    time += dt;
+
+    move(input, dt);
+    updateLimbs();
+    fall();
+    stream();
+
+    // Only the cells around the player's old and new position are relit
+    window->shadeMap->moveLight(playerRow() - window->originRow, playerCol() - window->originCol);
+
+    renderFrame.player = position;
+    renderFrame.falling = isFalling;
+    renderFrame.time = time;
+}
+
+void Simulation::stream() {
+    int row = playerRow();
+    int col = playerCol();
+    int chunkX = chunks.chunkOf(col);
+    int chunkY = chunks.chunkOf(row);
+    if (chunkX != playerChunkX || chunkY != playerChunkY) {
+        playerChunkX = chunkX;
+        playerChunkY = chunkY;
+        int size = chunks.chunkSize();
+        chunks.prefetch(chunkX, chunkY, PREFETCH_RADIUS, (mapCols + size - 1) / size, (mapRows + size - 1) / size);
+    }
+
+    // A finished window is swapped in; an unfinished one is waited for once the player nears the
+    // edge of the current window. One built for a chunk the player has since left is dropped if
+    // it does not cover the player with the margin.
+    bool urgent = nearEdge(*window, row, col);
+    if (nextWindow.valid() && (urgent || nextWindow.wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
+        std::unique_ptr<Window> next = nextWindow.get();
+        if (!nearEdge(*next, row, col)) {
+            install(std::move(next));
+            urgent = false;
+        }
+    }
+    if (window->chunkX == chunkX && window->chunkY == chunkY) return;
+
+    if (urgent) {
+        install(buildWindow(chunkX, chunkY, row, col));
+    } else if (!nextWindow.valid()) {
+        nextWindow = std::async(std::launch::async, &Simulation::buildWindow, this, chunkX, chunkY, row, col);
+    }
+}
+
+std::unique_ptr<Simulation::Window> Simulation::buildWindow(int chunkX, int chunkY, int lightRow, int lightCol) {
+    int size = chunks.chunkSize();
+    int rowBegin = std::max((chunkY - WINDOW_RADIUS) * size, 0);
+    int rowEnd = std::min((chunkY + WINDOW_RADIUS + 1) * size, mapRows);
+    int colBegin = std::max((chunkX - WINDOW_RADIUS) * size, 0);
+    int colEnd = std::min((chunkX + WINDOW_RADIUS + 1) * size, mapCols);
+
+    std::unique_ptr<Window> next(new Window());
+    next->chunkX = chunkX;
+    next->chunkY = chunkY;
+    next->originRow = rowBegin;
+    next->originCol = colBegin;
+    chunks.copyRegion(next->level, rowBegin, colBegin, rowEnd - rowBegin, colEnd - colBegin);
+
+    // Static lights are shadowcast and baked once per window; only the player's light moves per step
+    const Level& level = next->level;
+    next->lightIndex.build(level.grid.rows(), level.grid.cols(), level.lights.data(), level.lights.size());
+    next->lightMap.build(next->lightIndex, level.grid);
+    next->shadeMap.reset(new ShadeMap(next->lightMap, lightRow - rowBegin, lightCol - colBegin));
+    return next;
+}
+
+void Simulation::install(std::unique_ptr<Window> next) {
+    window = std::move(next);
+    window->shadeMap->moveLight(playerRow() - window->originRow, playerCol() - window->originCol);
+    renderFrame.windowRow = window->originRow;
+    renderFrame.windowCol = window->originCol;
+    ++renderFrame.windowVersion;
+}
+
+bool Simulation::nearEdge(const Window& w, int row, int col) const {
+    int rowBegin = w.originRow;
+    int rowEnd = w.originRow + w.level.grid.rows();
+    int colBegin = w.originCol;
+    int colEnd = w.originCol + w.level.grid.cols();
+    if (row < rowBegin || row >= rowEnd || col < colBegin || col >= colEnd) return true;
+
+    return (rowBegin > 0 && row - rowBegin < WINDOW_MARGIN) || (rowEnd < mapRows && rowEnd - row <= WINDOW_MARGIN) ||
+           (colBegin > 0 && col - colBegin < WINDOW_MARGIN) || (colEnd < mapCols && colEnd - col <= WINDOW_MARGIN);
+}
+
+// Starts a one-cell move when a direction is held, then interpolates the position between the old
+// and new cell over MOVE_DURATION. No upward moves while falling.
+void Simulation::move(const SimInput& input, float dt) {
+    if (isMoving) {
+        moveElapsed += dt;
+    } else {
+        Vec2 newPos = position;
+
+        bool keyPressed = false;
+        if (input.up && input.left && !isFalling) {
+            newPos.y -= GRID_SPACING;
+            newPos.x -= GRID_SPACING;
+            keyPressed = true;
+        } else if (input.up && input.right && !isFalling) {
+            newPos.y -= GRID_SPACING;
+            newPos.x += GRID_SPACING;
+            keyPressed = true;
+        } else if (input.down && input.left) {
+            newPos.y += GRID_SPACING;
+            newPos.x -= GRID_SPACING;
+            keyPressed = true;
+        } else if (input.down && input.right) {
+            newPos.y += GRID_SPACING;
+            newPos.x += GRID_SPACING;
+            keyPressed = true;
+        } else if (input.up && !isFalling) {
+            newPos.y -= GRID_SPACING;
+            keyPressed = true;
+        } else if (input.down) {
+            newPos.y += GRID_SPACING;
+            keyPressed = true;
+        } else if (input.left) {
+            newPos.x -= GRID_SPACING;
+            keyPressed = true;
+        } else if (input.right) {
+            newPos.x += GRID_SPACING;
+            keyPressed = true;
+        }
+
+        int newRow = static_cast<int>(newPos.y / GRID_SPACING);
+        int newCol = static_cast<int>(newPos.x / GRID_SPACING);
+
+        // The window always covers the cells around the player, so the target cell is inside it
+        const Grid& grid = window->level.grid;
+        int row = newRow - window->originRow;
+        int col = newCol - window->originCol;
+        if (keyPressed && isInBounds(newRow, newCol, rows(), cols()) && grid[row][col] != WALL && grid[row][col] != LIGHT) {
+            startPos = position;
+            endPos = Vec2(newCol * GRID_SPACING, newRow * GRID_SPACING);
+            moveElapsed = 0.0f;
+            isMoving = true;
+        }
+    }
+
+    if (isMoving) {
+        float t = moveElapsed * 1e6f / MOVE_DURATION;
+        if (t >= 1.f) {
+            t = 1.f;
+            isMoving = false;
+        }
+        position = startPos + t * (endPos - startPos);
+    }
+}
+
+// Casts a limb from the body toward each hexagon point; a limb only holds on to a wall within reach
+void Simulation::updateLimbs() {
+    Vec2 center = position + Vec2(GRID_SPACING / 2, GRID_SPACING / 2);
+    renderFrame.hexagonPoints = getHexagonalPoints(position);
+
+    // Rays are cast in window pixels
+    Vec2 origin(window->originCol * GRID_SPACING, window->originRow * GRID_SPACING);
+    renderFrame.limbs.clear();
+    for (const Vec2& point : renderFrame.hexagonPoints) {
+        Vec2 direction = point - position + Vec2(GRID_SPACING / 2, GRID_SPACING / 2);
+        Vec2 wallPos = findClosestWall(center - origin, direction, window->level.grid) + origin;
+        renderFrame.limbs.push_back(Limb(center, wallPos));
+    }
+
+    for (Limb& limb : renderFrame.limbs) {
+        limb.animate(1.f); // Animate the limb
+    }
+}
+
+// With fewer than three limbs holding on, the spider falls
+void Simulation::fall() {
+    // Count active limbs
+    int activeLimbs = 0;
+    for (const Limb& limb : renderFrame.limbs) {
+        if (limb.active) {
+            activeLimbs++;
+        }
+    }
+    if (activeLimbs == 0) {
+        // No limbs connected: full GRAVITY
+        fallingSpeed += GRAVITY;
+        isFalling = true;
+    } else if (activeLimbs < 3) {
+        // Less than 3 limbs: scaled GRAVITY
+        fallingSpeed += GRAVITY / activeLimbs;
+        isFalling = true;
+    } else {
+        fallingSpeed = 0.0f;
+        isFalling = false;
+    }
+    if (fallingSpeed > TERM_VELO) {
+        fallingSpeed = TERM_VELO;
+    }
+    position.y += fallingSpeed;
+
+    // Prevent the player from falling below the grid; the player's cell must stay a map cell, since
+    // the window holds no cells past the map
+    if (position.y > rows() * GRID_SPACING - GRID_SPACING) {
+        position.y = rows() * GRID_SPACING - GRID_SPACING;
+        fallingSpeed = 0.0f; // Reset falling speed
+        isFalling = false;
+    }
+}
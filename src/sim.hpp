@@ -0,0 +1,127 @@
+// sim.hpp
+#ifndef SIM_H
+#define SIM_H
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "connectivity.hpp"
+#include "lighting.hpp"
+#include "spider.hpp"
+#include "vec2.hpp"
+#include "world.hpp"
+
+#define MOVE_DURATION 60000 // Duration of player movement in microseconds
+#define GRAVITY 0.01f // Falling speed gained per step, in pixels per step
+#define TERM_VELO 5.0f // Maximum falling speed, in pixels per step
+#define WINDOW_RADIUS 1 // The simulation works on the chunks within this many chunks of the player's
+#define PREFETCH_RADIUS 2 // Chunks within this many chunks of the player's are generated ahead
+// The player is never closer than this to an edge of the window that is not a map edge: half the
+// 800 px view plus LIGHT_REACH, so everything on screen is inside the window and lit as in the
+// whole map. Must stay below CHUNK_SIZE.
+#define WINDOW_MARGIN 48
+
+// Creates the chunked world for seed. Every chunk is generated and decorated by the pipeline set
+// up here on the world's worker thread, or mapped from the maze cache if it was made before.
+std::unique_ptr<ChunkWorld> createWorld(uint64_t seed);
+
+// Buttons held during one step; a frontend maps its keys onto these
+struct SimInput {
+    bool up;
+    bool down;
+    bool left;
+    bool right;
+
+    SimInput() : up(false), down(false), left(false), right(false) {}
+};
+
+// Everything a frontend needs to draw the state after a step, in map pixels. Tiles are drawn from
+// level() and shades(), whose cell (0, 0) is map cell (windowRow, windowCol); shades().dirty()
+// lists the cells whose shade the last step changed.
+struct RenderFrame {
+    Vec2 player; // Top-left corner of the player's cell
+    std::vector<Vec2> hexagonPoints; // Where the limbs reach for walls
+    std::vector<Limb> limbs;
+    bool falling;
+    float time; // Seconds simulated so far; drives the tree sway
+    int windowRow;
+    int windowCol;
+    unsigned windowVersion; // Changes whenever the window is replaced; tiles and trees are then rebuilt
+};
+
+// The game without a window: player movement, limbs, falling and lighting over a rows x cols map
+// at the origin of a chunked world. step() advances it by one frame from an input, so it can be
+// driven by the SFML frontend at the display rate or by a headless loop as fast as the CPU allows.
+//
+// Only a window of WINDOW_RADIUS chunks around the player's chunk is held, with its lights baked.
+// When the player enters another chunk, the chunks around it are prefetched and the window for it
+// is built on another thread from resident chunks, then swapped in. The swap is forced before the
+// player gets within WINDOW_MARGIN cells of the window's edge, and everything the player's state
+// depends on lies within that margin, so the simulation is identical however long a build takes.
+class Simulation {
+public:
+    // The world must outlive the simulation
+    Simulation(ChunkWorld& world, int rows, int cols, int threads);
+
+    // Advances by dt seconds. Moves between cells are timed by dt; gravity and the limbs advance
+    // once per step, as they always did once per frame.
+    void step(const SimInput& input, float dt);
+
+    const RenderFrame& frame() const { return renderFrame; }
+    // The current window, in window cells
+    const Level& level() const { return window->level; }
+    const ShadeMap& shades() const { return *window->shadeMap; }
+    // Caves of the window the player spawned in, in that window's cells
+    const ConnectivityIndex& connectivity() const { return caves; }
+    int rows() const { return mapRows; }
+    int cols() const { return mapCols; }
+
+private:
+    // The map cells within WINDOW_RADIUS chunks of one chunk, with their lights baked
+    struct Window {
+        int chunkX, chunkY; // Chunk the window is built around
+        int originRow, originCol; // Map cell of level.grid[0][0]
+        Level level;
+        LightIndex lightIndex;
+        LightMap lightMap;
+        std::unique_ptr<ShadeMap> shadeMap; // Refers to lightMap, which refers to level.grid
+    };
+
+    ChunkWorld& chunks;
+    int mapRows;
+    int mapCols;
+    std::unique_ptr<Window> window;
+    std::future<std::unique_ptr<Window>> nextWindow; // Being built for the player's chunk
+    int playerChunkX;
+    int playerChunkY;
+    ConnectivityIndex caves;
+
+    Vec2 position;
+    Vec2 startPos;
+    Vec2 endPos;
+    bool isMoving;
+    float moveElapsed; // Seconds since the current move started
+    float fallingSpeed;
+    bool isFalling;
+    float time;
+
+    RenderFrame renderFrame;
+
+    int playerRow() const { return static_cast<int>(position.y / GRID_SPACING); }
+    int playerCol() const { return static_cast<int>(position.x / GRID_SPACING); }
+
+    void move(const SimInput& input, float dt);
+    void updateLimbs();
+    void fall();
+
+    // Prefetches around the player's chunk when it changes and swaps windows as described above
+    void stream();
+    std::unique_ptr<Window> buildWindow(int chunkX, int chunkY, int lightRow, int lightCol);
+    void install(std::unique_ptr<Window> next);
+    // Whether map cell (row, col) is outside w or within WINDOW_MARGIN of one of its inner edges
+    bool nearEdge(const Window& w, int row, int col) const;
+};
+
+#endif // SIM_H
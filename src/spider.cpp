@@ -1,7 +1,7 @@
 #include "spider.hpp"
 
-std::vector<sf::Vector2f> getHexagonalPoints(const sf::Vector2f& playerPosition) {
-    std::vector<sf::Vector2f> points;
+std::vector<Vec2> getHexagonalPoints(const Vec2& playerPosition) {
+    std::vector<Vec2> points;
     float angles[] = {0, 60, 120, 180, 240, 300}; // hexagon angles
 
     for (float angle : angles) {
@@ -14,28 +14,33 @@ std::vector<sf::Vector2f> getHexagonalPoints(const sf::Vector2f& playerPosition)
     return points;
 }
 
-sf::Vector2f findClosestWall(const sf::Vector2f& start, const sf::Vector2f& direction, 
-                             const std::vector<std::vector<int>>& gridColors, int rows, int cols) {
-    sf::Vector2f current = start;
-    sf::Vector2f step = direction / std::sqrt(direction.x * direction.x + direction.y * direction.y); // Normalize direction
+Vec2 findClosestWall(const Vec2& start, const Vec2& direction, 
+                             const Grid& gridColors) {
+    Vec2 current = start;
+    Vec2 step = direction / std::sqrt(direction.x * direction.x + direction.y * direction.y); // Normalize direction
     step *= GRID_SPACING / 10.0f; // Step size
 
-    while (true) {
+    // A wall further than this could only make an inactive limb, so the march stops there rather
+    // than crossing the whole map
+    int maxSteps = static_cast<int>((HEXAGON_DISTANCE + GRID_SPACING) / (GRID_SPACING / 10.0f)) + 1;
+    for (int steps = 0; steps <= maxSteps; ++steps) {
         int row = static_cast<int>(current.y / GRID_SPACING);
         int col = static_cast<int>(current.x / GRID_SPACING);
 
         // Check if out of bounds
-        if (row < 0 || col < 0 || row >= rows || col >= cols) {
-            break; // Out of grid, return the last position
+        if (!gridColors.inBounds(row, col)) {
+            break; // Out of grid, nothing to hold on to
         }
 
         // Check for a wall
         if (gridColors[row][col] == WALL) {
-            return sf::Vector2f(col * GRID_SPACING + GRID_SPACING / 2, row * GRID_SPACING + GRID_SPACING / 2); // Center of wall cell
+            return Vec2(col * GRID_SPACING + GRID_SPACING / 2, row * GRID_SPACING + GRID_SPACING / 2); // Center of wall cell
         }
 
         current += step;
     }
 
-    return start; // No wall found, return the starting position
+    // No wall within reach, whether the ray left the grid or ran past the limit: a point beyond
+    // HEXAGON_DISTANCE, so the limb is inactive either way
+    return start + step * static_cast<float>(maxSteps + 1);
 }
\ No newline at end of file
@@ -1,8 +1,14 @@
-#include <SFML/Graphics.hpp>
+// spider.hpp
+#ifndef SPIDER_H
+#define SPIDER_H
+
 // #include "mazegen.hpp"
 #include <vector>
 #include <cmath>
 
+#include "grid.hpp"
+#include "vec2.hpp"
+
 // Constants for the octagon
 #define HEXAGON_DISTANCE 90.0f // Distance of circles from player
 #define CIRCLE_RADIUS 2.0f     // Radius of each circle
@@ -11,13 +17,13 @@
 #define PATH 1
 
 struct Limb {
-    sf::Vector2f start;   // Starting position (player position)
-    sf::Vector2f end;     // Current endpoint (animated)
-    sf::Vector2f target;  // Final endpoint (wall position)
+    Vec2 start;   // Starting position (player position)
+    Vec2 end;     // Current endpoint (animated)
+    Vec2 target;  // Final endpoint (wall position)
     float progress;       // Progress of the animation (0 to 1)
     bool active;          // Whether the limb should animate
 
-    Limb(const sf::Vector2f& start, const sf::Vector2f& target)
+    Limb(const Vec2& start, const Vec2& target)
         : start(start), end(start), target(target), progress(0.0f), active(true) {
         // Calculate the distance from start to target
         float distance = std::sqrt(std::pow(target.x - start.x, 2) + std::pow(target.y - start.y, 2));
@@ -34,6 +40,7 @@ struct Limb {
     }
 };
 
-std::vector<sf::Vector2f> getHexagonalPoints(const sf::Vector2f& playerPosition);
-sf::Vector2f findClosestWall(const sf::Vector2f& start, const sf::Vector2f& direction, const std::vector<std::vector<int>>& gridColors, int rows, int cols);
-sf::Vector2f findStartingPosition(const std::vector<std::vector<int>>& gridColors, int rows, int cols);
\ No newline at end of file
+std::vector<Vec2> getHexagonalPoints(const Vec2& playerPosition);
+Vec2 findClosestWall(const Vec2& start, const Vec2& direction, const Grid& gridColors);
+
+#endif // SPIDER_H
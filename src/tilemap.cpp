@@ -0,0 +1,116 @@
+// tilemap.cpp
+#include "tilemap.hpp"
+
+#include <cmath>
+
+TileKind tileKind(const Grid& grid, int row, int col) {
+    uint8_t cell = grid[row][col];
+    if (cell == WALL) {
+        bool covered = row > 0 && (grid[row - 1][col] == WALL || grid[row - 1][col] == LIGHT);
+        return covered ? TILE_WALL : TILE_SURFACE;
+    }
+    if (cell == PATH) return TILE_BACKGROUND;
+    if (cell == LIGHT) return TILE_LIGHT;
+    return TILE_NONE;
+}
+
+CellRect visibleCells(const sf::View& view, float tileSize, int rows, int cols, int margin) {
+    sf::Vector2f corner = view.getCenter() - view.getSize() / 2.0f;
+    sf::Vector2f size = view.getSize();
+    int rowBegin = static_cast<int>(std::floor(corner.y / tileSize)) - margin;
+    int rowEnd = static_cast<int>(std::ceil((corner.y + size.y) / tileSize)) + margin;
+    int colBegin = static_cast<int>(std::floor(corner.x / tileSize)) - margin;
+    int colEnd = static_cast<int>(std::ceil((corner.x + size.x) / tileSize)) + margin;
+    return CellRect(std::max(rowBegin, 0), std::min(rowEnd, rows), std::max(colBegin, 0), std::min(colEnd, cols));
+}
+
+TileMap::TileMap(const TextureAtlas& atlas, const int tiles[TILE_KINDS], float tileSize)
+    : atlas(atlas), tileSize(tileSize), rows(0), cols(0), originRow(0), originCol(0), vertices(sf::Quads) {
+    for (int kind = 0; kind < TILE_KINDS; ++kind) {
+        this->tiles[kind] = tiles[kind];
+    }
+}
+
+void TileMap::build(const Grid& grid, const ShadeMap& shades, int originRow, int originCol) {
+    rows = grid.rows();
+    cols = grid.cols();
+    this->originRow = originRow;
+    this->originCol = originCol;
+    kinds.assign(grid.size(), TILE_NONE);
+    vertices.resize(grid.size() * 4);
+
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < cols; ++col) {
+            sf::Vertex* quad = &vertices[(static_cast<size_t>(row) * cols + col) * 4];
+            float left = (originCol + col) * tileSize;
+            float top = (originRow + row) * tileSize;
+            quad[0].position = sf::Vector2f(left, top);
+            quad[1].position = sf::Vector2f(left + tileSize, top);
+            quad[2].position = sf::Vector2f(left + tileSize, top + tileSize);
+            quad[3].position = sf::Vector2f(left, top + tileSize);
+
+            setKind(row, col, tileKind(grid, row, col));
+            setShade(row, col, shades.shade(row, col));
+        }
+    }
+}
+
+void TileMap::cellChanged(const Grid& grid, int row, int col) {
+    for (int r = row; r <= row + 1 && r < rows; ++r) {
+        TileKind kind = tileKind(grid, r, col);
+        if (kinds[static_cast<size_t>(r) * cols + col] != kind) setKind(r, col, kind);
+    }
+}
+
+void TileMap::updateShades(const ShadeMap& shades) {
+    for (const CellRect& region : shades.dirty()) {
+        for (int row = region.rowBegin; row < region.rowEnd; ++row) {
+            for (int col = region.colBegin; col < region.colEnd; ++col) {
+                setShade(row, col, shades.shade(row, col));
+            }
+        }
+    }
+}
+
+void TileMap::setKind(int row, int col, TileKind kind) {
+    size_t cell = static_cast<size_t>(row) * cols + col;
+    kinds[cell] = static_cast<uint8_t>(kind);
+
+    // Cells that are not drawn collapse their texture coordinates and go transparent
+    sf::Vertex* quad = &vertices[cell * 4];
+    sf::IntRect rect = kind == TILE_NONE ? sf::IntRect() : atlas.rect(tiles[kind]);
+    float left = static_cast<float>(rect.left);
+    float top = static_cast<float>(rect.top);
+    float right = static_cast<float>(rect.left + rect.width);
+    float bottom = static_cast<float>(rect.top + rect.height);
+    quad[0].texCoords = sf::Vector2f(left, top);
+    quad[1].texCoords = sf::Vector2f(right, top);
+    quad[2].texCoords = sf::Vector2f(right, bottom);
+    quad[3].texCoords = sf::Vector2f(left, bottom);
+    for (int i = 0; i < 4; ++i) {
+        quad[i].color.a = kind == TILE_NONE ? 0 : 255;
+    }
+}
+
+void TileMap::setShade(int row, int col, uint8_t shade) {
+    sf::Vertex* quad = &vertices[(static_cast<size_t>(row) * cols + col) * 4];
+    for (int i = 0; i < 4; ++i) {
+        quad[i].color.r = quad[i].color.g = quad[i].color.b = shade;
+    }
+}
+
+void TileMap::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    // Rows of a map are contiguous in the vertex array, so the visible part of each row is one copy
+    CellRect inView = visibleCells(target.getView(), tileSize, originRow + rows, originCol + cols, 0);
+    CellRect region(std::max(inView.rowBegin - originRow, 0), inView.rowEnd - originRow,
+                    std::max(inView.colBegin - originCol, 0), inView.colEnd - originCol);
+    if (region.empty()) return;
+    visible.clear();
+    for (int row = region.rowBegin; row < region.rowEnd; ++row) {
+        const sf::Vertex* begin = &vertices[(static_cast<size_t>(row) * cols + region.colBegin) * 4];
+        visible.insert(visible.end(), begin, begin + (region.colEnd - region.colBegin) * 4);
+    }
+
+    states.texture = &atlas.texture();
+    target.draw(&visible[0], visible.size(), sf::Quads, states);
+}
@@ -0,0 +1,64 @@
+// tilemap.hpp
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "atlas.hpp"
+#include "lighting.hpp"
+
+// Texture a cell is drawn with
+enum TileKind {
+    TILE_WALL = 0,       // Wall under another wall or light
+    TILE_SURFACE = 1,    // Wall with open space above it
+    TILE_BACKGROUND = 2, // PATH
+    TILE_LIGHT = 3,
+    TILE_KINDS = 4,
+    TILE_NONE = 255      // Not drawn
+};
+
+TileKind tileKind(const Grid& grid, int row, int col);
+
+#define VIEW_MARGIN 8 // Cells drawn beyond each edge of the view, for things that overhang their cell
+
+// Cells of a rows x cols map covered by view, grown by margin cells on every side and clipped to the map
+CellRect visibleCells(const sf::View& view, float tileSize, int rows, int cols, int margin = VIEW_MARGIN);
+
+// Draws the grid from one persistent vertex array over a texture atlas, in one draw call with one
+// texture bind. Every cell owns the quad at its row-major index, so a cell changing kind only
+// rewrites its texture coordinates, and vertex colors are only rewritten for the cells whose shade
+// changed. Only the quads under the target's view are submitted, so the draw cost follows the
+// window size rather than the map size.
+class TileMap : public sf::Drawable {
+public:
+    // tiles[kind] is the atlas tile stretched over one cell; the atlas must outlive the map
+    TileMap(const TextureAtlas& atlas, const int tiles[TILE_KINDS], float tileSize);
+
+    // Rebuilds every quad and colors it from shades. Cell (0, 0) of the grid is drawn at map cell
+    // (originRow, originCol), so a window of a larger map lands in place.
+    void build(const Grid& grid, const ShadeMap& shades, int originRow = 0, int originCol = 0);
+    // A cell's kind also depends on the cell above it, so the tile below is refreshed as well
+    void cellChanged(const Grid& grid, int row, int col);
+    // Recolors the cells in shades.dirty()
+    void updateShades(const ShadeMap& shades);
+
+private:
+    const TextureAtlas& atlas;
+    int tiles[TILE_KINDS];
+    float tileSize;
+    int rows;
+    int cols;
+    int originRow;
+    int originCol;
+    sf::VertexArray vertices;
+    std::vector<uint8_t> kinds; // TileKind per cell
+    mutable std::vector<sf::Vertex> visible; // Quads under the view, gathered per draw
+
+    void setKind(int row, int col, TileKind kind);
+    void setShade(int row, int col, uint8_t shade);
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+};
+
+#endif // TILEMAP_H
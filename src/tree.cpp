@@ -1,52 +1,94 @@
 // tree.cpp
-#include <SFML/Graphics.hpp>
-#include <cmath>
-#include <vector>
-#include <cstdlib>
-#include <ctime>
+#include "tree.hpp"
 
+#include <algorithm>
+
+#define TREE_COLOR sf::Color{ 100 , 95, 145 }
 
 float toRadians(float degrees) {
     return degrees * (M_PI / 180.0f);
 }
 
-// Recursive function to draw a tree with inverse kinematics
-void drawIKTree(sf::RenderWindow &window, sf::Vector2f start, float length, float angle, int depth, int branchingFactor, float swayOffset, float time) {
-    if (depth <= 0 || length <= 1) {
-        return;
+// sin and cos from short polynomials, accurate to about 1e-5, after folding x into [-pi/2, pi/2]
+static void approxSinCos(float x, float& sine, float& cosine) {
+    const float pi = static_cast<float>(M_PI);
+    x -= 2 * pi * std::floor(x / (2 * pi) + 0.5f);
+    float sign = 1.0f;
+    if (x > pi / 2) {
+        x = pi - x;
+        sign = -1.0f;
+    } else if (x < -pi / 2) {
+        x = -pi - x;
+        sign = -1.0f;
     }
+    float x2 = x * x;
+    sine = x * (1 + x2 * (-1.0f / 6 + x2 * (1.0f / 120 + x2 * (-1.0f / 5040 + x2 * (1.0f / 362880)))));
+    cosine = sign * (1 + x2 * (-1.0f / 2 + x2 * (1.0f / 24 + x2 * (-1.0f / 720 + x2 * (1.0f / 40320)))));
+}
 
-    // Calculate sway based on time and depth for a layered animation effect
-    float dynamicSway = swayOffset * std::sin(time + depth * 0.5f);
-
-    // Calculate the end point of the current branch
-    sf::Vector2f end(
-        start.x + length * cos(toRadians(angle + dynamicSway)),
-        start.y - length * sin(toRadians(angle + dynamicSway))
-    );
+// Grows the tree level by level with the same stopping rule as the recursive walk
+TreeSkeleton::TreeSkeleton(float length, float angle, int depth, int branchingFactor) : depth(depth) {
+    float branchAngleIncrement = 60.0f / (branchingFactor - 1);
 
-    // Draw the line for the current branch
-    sf::Vertex line[] = {
-        sf::Vertex(start, sf::Color{ 100 , 95, 145 }),
-        sf::Vertex(end, sf::Color{ 100 , 95, 145 })
-    };
-    window.draw(line, 2, sf::Lines);
+    std::vector<float> angles(1, angle);
+    levelStart.push_back(0);
+    if (depth > 0 && length > 1) {
+        parent.push_back(-1);
+    }
+    while (static_cast<int>(parent.size()) > levelStart.back()) {
+        int begin = levelStart.back();
+        int end = static_cast<int>(parent.size());
+        levelStart.push_back(end);
+        levelLength.push_back(length);
 
-//     std::srand(std::time(0));
+        length *= 0.7f;
+        if (depth - levels() <= 0 || length <= 1) break;
+        for (int branch = begin; branch < end; ++branch) {
+            for (int i = 0; i < branchingFactor; ++i) {
+                parent.push_back(branch);
+                angles.push_back(angles[branch] - 30 + i * branchAngleIncrement);
+            }
+        }
+    }
 
-// float randomAngle = 45.0f + static_cast<float>(std::rand()) / (static_cast<float>(RAND_MAX) / (120.0f - 45.0f));
-// float branchAngleIncrement = randomAngle / (branchingFactor - 1);
+    for (size_t branch = 0; branch < parent.size(); ++branch) {
+        dirCos.push_back(cos(toRadians(angles[branch])));
+        dirSin.push_back(sin(toRadians(angles[branch])));
+    }
+}
 
+int TreeSkeleton::levelsFor(float minLength) const {
+    int count = 0;
+    while (count < levels() && levelLength[count] >= minLength) ++count;
+    return count;
+}
 
-    // Calculate new branches
-    float branchAngleIncrement = 60.0f / (branchingFactor - 1);
-    for (int i = 0; i < branchingFactor; ++i) {
-        float newAngle = angle - 30 + i * branchAngleIncrement;
+void TreeBatch::addTree(const TreeSkeleton& skeleton, sf::Vector2f start, float swayOffset, float time, int levels) {
+    levels = std::min(levels, skeleton.levels());
+    if (levels <= 0) return;
+    ends.resize(skeleton.levelStart[levels]);
 
-        // Add sway to child branches for smoother motion
-        float childSwayOffset = dynamicSway * 0.5f;
+    for (int level = 0; level < levels; ++level) {
+        // Every branch of a level shares the sway, so rotating by it costs one sin/cos per level
+        float phase, unused;
+        approxSinCos(time + (skeleton.depth - level) * 0.5f, phase, unused);
+        float dynamicSway = swayOffset * phase;
+        float swaySin, swayCos;
+        approxSinCos(toRadians(dynamicSway), swaySin, swayCos);
+        swayOffset = dynamicSway * 0.5f;
 
-        // Recursively draw branches
-        drawIKTree(window, end, length * 0.7f, newAngle, depth - 1, branchingFactor, childSwayOffset, time);
+        float length = skeleton.levelLength[level];
+        for (int branch = skeleton.levelStart[level]; branch < skeleton.levelStart[level + 1]; ++branch) {
+            sf::Vector2f from = level == 0 ? start : ends[skeleton.parent[branch]];
+            float c = skeleton.dirCos[branch] * swayCos - skeleton.dirSin[branch] * swaySin;
+            float s = skeleton.dirSin[branch] * swayCos + skeleton.dirCos[branch] * swaySin;
+            ends[branch] = sf::Vector2f(from.x + length * c, from.y - length * s);
+            lines.append(sf::Vertex(from, TREE_COLOR));
+            lines.append(sf::Vertex(ends[branch], TREE_COLOR));
+        }
     }
-}
\ No newline at end of file
+}
+
+void TreeBatch::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    target.draw(lines, states);
+}
@@ -5,9 +5,54 @@
 #include <cmath>
 #include <cstdlib>
 #include <ctime>
+#include <vector>
 
 #include <SFML/Graphics.hpp>
 
-void drawIKTree(sf::RenderWindow &window, sf::Vector2f start, float length, float angle, int depth, int branchingFactor, float swayOffset, float time);
+#define TREE_LOD_MIN_LENGTH 2.0f // Shortest branch drawn next to the focus point, in pixels
+#define TREE_LOD_DISTANCE 150.0f // Distance from the focus point at which the shortest branch drawn doubles
 
-#endif // TREE_H
\ No newline at end of file
+// Branch topology of one tree variant, computed once and shared by every tree of that variant.
+// Branches are stored breadth first as structure-of-arrays, so level k is the index range
+// [levelStart[k], levelStart[k + 1]), every parent precedes its children, and cutting the deepest
+// levels for level of detail is just a shorter range.
+struct TreeSkeleton {
+    int depth; // Depth the tree was grown with; level k sways with phase depth - k
+    std::vector<int> levelStart;
+    std::vector<float> levelLength; // Every branch of a level has the same length
+    std::vector<int> parent; // Index of the parent branch, -1 for the trunk
+    std::vector<float> dirCos; // Unswayed branch angle as cos and sin
+    std::vector<float> dirSin;
+
+    TreeSkeleton(float length, float angle, int depth, int branchingFactor);
+
+    int levels() const { return static_cast<int>(levelLength.size()); }
+    // Number of levels whose branches are at least minLength long
+    int levelsFor(float minLength) const;
+};
+
+// Collects the branches of any number of swaying IK trees into one vertex array, so a whole forest
+// is submitted in a single draw call. Clear it, add the trees in view, then draw it; the buffers
+// keep their capacity, so steady-state frames do not allocate.
+class TreeBatch : public sf::Drawable {
+public:
+    TreeBatch() : lines(sf::Lines) {}
+
+    void clear() { lines.clear(); }
+
+    // Appends an instance of a precomputed skeleton rooted at start, drawing only its first `levels`
+    // levels. Level k sways by offset * sin(time + (depth - k) * 0.5) degrees, where the offset is
+    // swayOffset for the trunk and half the sway of the level above otherwise. The sway is one
+    // angle per level, so each branch costs a rotation and an add.
+    void addTree(const TreeSkeleton& skeleton, sf::Vector2f start, float swayOffset, float time, int levels);
+
+    size_t branchCount() const { return lines.getVertexCount() / 2; }
+
+private:
+    sf::VertexArray lines;
+    std::vector<sf::Vector2f> ends; // Branch end points of the skeleton instance being added
+
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+};
+
+#endif // TREE_H
@@ -0,0 +1,28 @@
+// vec2.hpp
+#ifndef VEC2_H
+#define VEC2_H
+
+// 2D point or direction in pixels. The simulation uses this instead of sf::Vector2f so it builds
+// and runs without SFML; the frontend converts at the draw calls.
+struct Vec2 {
+    float x;
+    float y;
+
+    Vec2() : x(0), y(0) {}
+    Vec2(float x, float y) : x(x), y(y) {}
+
+    Vec2& operator+=(const Vec2& other) { x += other.x; y += other.y; return *this; }
+    Vec2& operator-=(const Vec2& other) { x -= other.x; y -= other.y; return *this; }
+    Vec2& operator*=(float scale) { x *= scale; y *= scale; return *this; }
+    Vec2& operator/=(float scale) { x /= scale; y /= scale; return *this; }
+};
+
+inline Vec2 operator+(Vec2 a, const Vec2& b) { return a += b; }
+inline Vec2 operator-(Vec2 a, const Vec2& b) { return a -= b; }
+inline Vec2 operator*(Vec2 a, float scale) { return a *= scale; }
+inline Vec2 operator*(float scale, Vec2 a) { return a *= scale; }
+inline Vec2 operator/(Vec2 a, float scale) { return a /= scale; }
+inline bool operator==(const Vec2& a, const Vec2& b) { return a.x == b.x && a.y == b.y; }
+inline bool operator!=(const Vec2& a, const Vec2& b) { return !(a == b); }
+
+#endif // VEC2_H
@@ -0,0 +1,270 @@
+// world.cpp
+#include "world.hpp"
+
+#include <algorithm>
+
+ChunkWorld::ChunkWorld(GenerationPipeline* pipeline, uint64_t seed, const char* cacheDirectory,
+                       int chunkSize, size_t capacity)
+    : pipeline(pipeline), cache(cacheDirectory ? new MazeCache(cacheDirectory) : NULL), seed(seed),
+      size(chunkSize), capacity(std::max<size_t>(capacity, 1)), busy(false), busyKey(0), generatedChunks(0),
+      loadedChunks(0), stopping(false) {
+    pipeline->describe(chunkParams);
+    chunkParams.chunkSize = size;
+    chunkParams.rows = size;
+    chunkParams.cols = size;
+    chunkParams.seed = seed;
+    worker = std::thread(&ChunkWorld::workerLoop, this);
+}
+
+ChunkWorld::~ChunkWorld() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+uint64_t ChunkWorld::key(int chunkX, int chunkY) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(chunkX)) << 32) | static_cast<uint32_t>(chunkY);
+}
+
+int ChunkWorld::chunkOf(long cell) const {
+    return static_cast<int>(cell >= 0 ? cell / size : -((-cell + size - 1) / size));
+}
+
+void ChunkWorld::prefetch(int chunkX, int chunkY, int radius, int chunksAcross, int chunksDown) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Drop requests the player has moved away from, except the ones a caller is blocked on, then
+    // queue rings around the centre
+    pending.clear();
+    queued.clear();
+    for (const ChunkCoord& coord : awaited) {
+        enqueue(coord.x, coord.y, true);
+    }
+    for (int ring = 0; ring <= radius; ++ring) {
+        for (int dy = -ring; dy <= ring; ++dy) {
+            for (int dx = -ring; dx <= ring; ++dx) {
+                if (std::max(std::abs(dx), std::abs(dy)) != ring) continue;
+                int x = chunkX + dx;
+                int y = chunkY + dy;
+                if (chunksAcross > 0 && (x < 0 || x >= chunksAcross)) continue;
+                if (chunksDown > 0 && (y < 0 || y >= chunksDown)) continue;
+                enqueue(x, y, false);
+            }
+        }
+    }
+    wake.notify_one();
+}
+
+std::shared_ptr<const Chunk> ChunkWorld::find(int chunkX, int chunkY) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    ChunkPtr chunk = lookup(key(chunkX, chunkY));
+    if (!chunk) {
+        enqueue(chunkX, chunkY, false);
+        wake.notify_one();
+    }
+    return chunk;
+}
+
+std::shared_ptr<const Chunk> ChunkWorld::get(int chunkX, int chunkY) {
+    std::unique_lock<std::mutex> lock(mutex);
+    uint64_t chunkKey = key(chunkX, chunkY);
+
+    ChunkPtr chunk = lookup(chunkKey);
+    if (chunk) return chunk;
+
+    awaited.push_back(ChunkCoord(chunkX, chunkY));
+    while (!(chunk = lookup(chunkKey))) {
+        enqueue(chunkX, chunkY, true);
+        wake.notify_one();
+        ready.wait(lock);
+    }
+    for (std::vector<ChunkCoord>::iterator it = awaited.begin(); it != awaited.end(); ++it) {
+        if (key(it->x, it->y) == chunkKey) {
+            awaited.erase(it);
+            break;
+        }
+    }
+    return chunk;
+}
+
+uint8_t ChunkWorld::cellAt(long row, long col) {
+    int chunkX = chunkOf(col);
+    int chunkY = chunkOf(row);
+    ChunkPtr chunk = find(chunkX, chunkY);
+    if (!chunk) return WALL;
+    return chunk->level.grid()[row - static_cast<long>(chunkY) * size][col - static_cast<long>(chunkX) * size];
+}
+
+void ChunkWorld::copyRegion(Level& out, long originRow, long originCol, int rows, int cols) {
+    out.grid.resize(rows, cols, WALL);
+    out.lights.clear();
+    out.trees.clear();
+    out.originRow = originRow;
+    out.originCol = originCol;
+    if (rows <= 0 || cols <= 0) return;
+
+    int firstX = chunkOf(originCol);
+    int lastX = chunkOf(originCol + cols - 1);
+    int firstY = chunkOf(originRow);
+    int lastY = chunkOf(originRow + rows - 1);
+
+    // Queue the whole region first so the worker never idles between blocking gets
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int chunkY = firstY; chunkY <= lastY; ++chunkY) {
+            for (int chunkX = firstX; chunkX <= lastX; ++chunkX) {
+                enqueue(chunkX, chunkY, false);
+            }
+        }
+        wake.notify_one();
+    }
+
+    for (int chunkY = firstY; chunkY <= lastY; ++chunkY) {
+        for (int chunkX = firstX; chunkX <= lastX; ++chunkX) {
+            ChunkPtr chunk = get(chunkX, chunkY);
+            const LevelView& level = chunk->level;
+            long chunkRow = static_cast<long>(chunkY) * size;
+            long chunkCol = static_cast<long>(chunkX) * size;
+
+            // Overlap of the chunk with the region, in world coordinates
+            long rowBegin = std::max(originRow, chunkRow);
+            long rowEnd = std::min(originRow + rows, chunkRow + size);
+            long colBegin = std::max(originCol, chunkCol);
+            long colEnd = std::min(originCol + cols, chunkCol + size);
+
+            for (long row = rowBegin; row < rowEnd; ++row) {
+                std::copy(level.grid()[row - chunkRow] + (colBegin - chunkCol),
+                          level.grid()[row - chunkRow] + (colEnd - chunkCol),
+                          out.grid[row - originRow] + (colBegin - originCol));
+            }
+
+            // Chunk cells become region cells by adding the chunk's offset within the region
+            long rowOffset = chunkRow - originRow;
+            long colOffset = chunkCol - originCol;
+            for (size_t i = 0; i < level.lightCount(); ++i) {
+                const Cell& light = level.lights()[i];
+                long row = light.row + rowOffset;
+                long col = light.col + colOffset;
+                if (row >= 0 && row < rows && col >= 0 && col < cols) out.lights.push_back(Cell(row, col));
+            }
+            for (size_t i = 0; i < level.treeCount(); ++i) {
+                const Cell& tree = level.trees()[i];
+                long row = tree.row + rowOffset;
+                long col = tree.col + colOffset;
+                if (row >= 0 && row < rows && col >= 0 && col < cols) out.trees.push_back(Cell(row, col));
+            }
+        }
+    }
+
+    // Each chunk's trees are row-major, but chunks side by side interleave by row
+    std::sort(out.trees.begin(), out.trees.end(), [](const Cell& a, const Cell& b) {
+        return a.row != b.row ? a.row < b.row : a.col < b.col;
+    });
+}
+
+void ChunkWorld::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        wake.wait(lock, [&] { return stopping || !pending.empty(); });
+        if (stopping) return;
+
+        ChunkCoord coord = pending.front();
+        pending.pop_front();
+        busyKey = key(coord.x, coord.y);
+        queued.erase(busyKey);
+        busy = true;
+
+        lock.unlock();
+        ChunkPtr chunk = generate(coord);
+        lock.lock();
+
+        busy = false;
+        lru.push_front(chunk);
+        resident[busyKey] = lru.begin();
+        while (lru.size() > capacity) {
+            const Chunk& oldest = *lru.back();
+            resident.erase(key(oldest.coord.x, oldest.coord.y));
+            lru.pop_back();
+        }
+        ready.notify_all();
+    }
+}
+
+ChunkWorld::ChunkPtr ChunkWorld::generate(const ChunkCoord& coord) {
+    MazeParams params = chunkParams;
+    params.chunkX = coord.x;
+    params.chunkY = coord.y;
+
+    LevelView level;
+    if (cache && cache->load(params, level)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++loadedChunks;
+    } else {
+        std::shared_ptr<Level> generated(new Level());
+        generated->originRow = static_cast<long>(coord.y) * size;
+        generated->originCol = static_cast<long>(coord.x) * size;
+        Rng rng(seed, key(coord.x, coord.y));
+        pipeline->run(*generated, size, size, rng);
+        if (cache) cache->store(params, *generated); // On failure the chunk is just generated again next time
+        level = LevelView(generated);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        addStats(pipeline->stats());
+    }
+    return ChunkPtr(new Chunk(coord, level));
+}
+
+ChunkWorld::ChunkPtr ChunkWorld::lookup(uint64_t chunkKey) {
+    std::unordered_map<uint64_t, std::list<ChunkPtr>::iterator>::iterator it = resident.find(chunkKey);
+    if (it == resident.end()) return ChunkPtr();
+
+    lru.splice(lru.begin(), lru, it->second); // Mark as most recently used
+    return *it->second;
+}
+
+void ChunkWorld::enqueue(int chunkX, int chunkY, bool urgent) {
+    uint64_t chunkKey = key(chunkX, chunkY);
+    if (resident.count(chunkKey) || (busy && busyKey == chunkKey)) return;
+
+    if (queued.count(chunkKey)) {
+        if (!urgent) return;
+        for (std::deque<ChunkCoord>::iterator it = pending.begin(); it != pending.end(); ++it) {
+            if (key(it->x, it->y) == chunkKey) {
+                pending.erase(it);
+                break;
+            }
+        }
+    }
+
+    queued.insert(chunkKey);
+    if (urgent) pending.push_front(ChunkCoord(chunkX, chunkY));
+    else pending.push_back(ChunkCoord(chunkX, chunkY));
+}
+
+void ChunkWorld::addStats(const std::vector<PassStats>& stats) {
+    ++generatedChunks;
+    if (generationStats.empty()) {
+        generationStats = stats;
+        return;
+    }
+    for (size_t i = 0; i < stats.size() && i < generationStats.size(); ++i) {
+        PassStats& total = generationStats[i];
+        total.seconds += stats[i].seconds;
+        total.peakRssKb = std::max(total.peakRssKb, stats[i].peakRssKb);
+        total.levelBytes = stats[i].levelBytes;
+        for (const auto& phase : stats[i].phases.entries()) {
+            total.phases.add(phase.first, phase.second);
+        }
+    }
+}
+
+void ChunkWorld::printStats(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    out << "Chunks generated: " << generatedChunks << ", loaded from cache: " << loadedChunks << std::endl;
+    if (!generationStats.empty()) printPassStats(out, generationStats);
+}
@@ -0,0 +1,114 @@
+// world.hpp
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "mazefile.hpp"
+#include "pipeline.hpp"
+
+#define CHUNK_SIZE 128 // Cells per chunk side
+#define CHUNK_CACHE_SIZE 64 // Chunks kept resident before the least recently used one is evicted
+
+struct ChunkCoord {
+    int x, y; // Chunk column and chunk row
+    ChunkCoord(int x, int y) : x(x), y(y) {}
+};
+
+// A generated and decorated chunk. Its level is in chunk coordinates: cell (0, 0) is world cell
+// (coord.y * size, coord.x * size).
+struct Chunk {
+    ChunkCoord coord;
+    LevelView level;
+    Chunk(const ChunkCoord& coord, const LevelView& level) : coord(coord), level(level) {}
+};
+
+// Unbounded world made of square chunks. Each chunk is made by running a generation pipeline
+// seeded from (seed, chunk coordinate) alone, so chunks can be produced in any order and
+// regenerate identically after eviction. Generation runs on a background worker, at most
+// `capacity` chunks stay resident, and with a cache directory every chunk is stored as a maze
+// file once and mapped from there afterwards.
+class ChunkWorld {
+public:
+    // Takes ownership of pipeline, which is only ever run on the worker thread. cacheDirectory may
+    // be NULL to always generate.
+    ChunkWorld(GenerationPipeline* pipeline, uint64_t seed, const char* cacheDirectory = NULL,
+               int chunkSize = CHUNK_SIZE, size_t capacity = CHUNK_CACHE_SIZE);
+    ~ChunkWorld();
+
+    int chunkSize() const { return size; }
+
+    // Replaces the pending queue with the missing chunks within `radius` of (chunkX, chunkY),
+    // nearest first, skipping chunks outside [0, chunksAcross) x [0, chunksDown) when those are
+    // positive. Chunks that get() is waiting for stay queued. Never blocks; (2 * radius + 1)^2
+    // should not exceed the cache capacity.
+    void prefetch(int chunkX, int chunkY, int radius, int chunksAcross = 0, int chunksDown = 0);
+
+    // Returns the chunk if resident and marks it recently used; otherwise queues it and returns NULL
+    std::shared_ptr<const Chunk> find(int chunkX, int chunkY);
+
+    // Blocks until the chunk is resident, moving it to the front of the queue if needed
+    std::shared_ptr<const Chunk> get(int chunkX, int chunkY);
+
+    // Cell at world coordinates, or WALL while its chunk has not been generated yet
+    uint8_t cellAt(long row, long col);
+
+    // Fills `out` with the rows x cols world region whose top-left cell is (originRow, originCol),
+    // blocking until every chunk it overlaps is resident. Lights and trees inside the region are
+    // copied too, in region coordinates, with the trees in row-major order.
+    void copyRegion(Level& out, long originRow, long originCol, int rows, int cols);
+
+    // Chunk coordinate containing a world row/column (rounds towards negative infinity)
+    int chunkOf(long cell) const;
+
+    // Prints how many chunks were generated and loaded, and each pass's total time over the
+    // generated ones
+    void printStats(std::ostream& out);
+
+private:
+    typedef std::shared_ptr<const Chunk> ChunkPtr;
+
+    std::unique_ptr<GenerationPipeline> pipeline;
+    std::unique_ptr<MazeCache> cache;
+    MazeParams chunkParams; // Cache key of a chunk, less its coordinate
+    uint64_t seed;
+    int size;
+    size_t capacity;
+
+    std::mutex mutex;
+    std::condition_variable wake;  // Worker: new work or shutdown
+    std::condition_variable ready; // Callers of get(): a chunk was inserted
+
+    std::deque<ChunkCoord> pending;
+    std::unordered_set<uint64_t> queued; // Keys of the chunks in `pending`
+    bool busy;                           // Worker is generating busyKey
+    uint64_t busyKey;
+    std::vector<ChunkCoord> awaited;     // Chunks that get() calls are blocked on
+
+    size_t generatedChunks, loadedChunks;
+    std::vector<PassStats> generationStats; // Summed over generated chunks; level size of the last
+
+    std::list<ChunkPtr> lru; // Most recently used first
+    std::unordered_map<uint64_t, std::list<ChunkPtr>::iterator> resident;
+
+    bool stopping;
+    std::thread worker;
+
+    static uint64_t key(int chunkX, int chunkY);
+    void workerLoop();
+    ChunkPtr generate(const ChunkCoord& coord);
+    ChunkPtr lookup(uint64_t chunkKey); // Caller holds the mutex
+    void enqueue(int chunkX, int chunkY, bool urgent); // Caller holds the mutex
+    void addStats(const std::vector<PassStats>& stats); // Caller holds the mutex
+};
+
+#endif // WORLD_H